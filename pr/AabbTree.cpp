@@ -0,0 +1,372 @@
+﻿// AabbTree.cpp
+#include "AabbTree.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // глубина обхода ограничена высотой сбалансированного дерева (~1.44 log2 n)
+    const int STACK_SIZE = 256;
+
+    Aabb merge(const Aabb& a, const Aabb& b) {
+        Aabb r;
+        r.lo = glm::min(a.lo, b.lo);
+        r.hi = glm::max(a.hi, b.hi);
+        return r;
+    }
+
+    // половина площади поверхности: стоимость узла в эвристике вставки
+    float area(const Aabb& a) {
+        glm::vec3 d = a.hi - a.lo;
+        return d.x * d.y + d.y * d.z + d.z * d.x;
+    }
+
+    bool contains(const Aabb& outer, const Aabb& inner) {
+        return outer.lo.x <= inner.lo.x && outer.lo.y <= inner.lo.y && outer.lo.z <= inner.lo.z &&
+            inner.hi.x <= outer.hi.x && inner.hi.y <= outer.hi.y && inner.hi.z <= outer.hi.z;
+    }
+
+    bool overlaps(const Aabb& a, const Aabb& b) {
+        return a.lo.x <= b.hi.x && b.lo.x <= a.hi.x && a.lo.y <= b.hi.y && b.lo.y <= a.hi.y &&
+            a.lo.z <= b.hi.z && b.lo.z <= a.hi.z;
+    }
+}
+
+bool ray_aabb(const glm::vec3& origin, const glm::vec3& inv_dir, const Aabb& box, float max_t, float* t) {
+    float t0 = 0.0f, t1 = max_t;
+    for (int a = 0; a < 3; a++) {
+        float n = (box.lo[a] - origin[a]) * inv_dir[a];
+        float f = (box.hi[a] - origin[a]) * inv_dir[a];
+        if (n > f) std::swap(n, f);
+        // NaN (луч в плоскости грани) не сужает отрезок
+        if (n > t0) t0 = n;
+        if (f < t1) t1 = f;
+        if (t0 > t1) return false;
+    }
+    *t = t0;
+    return true;
+}
+
+int AabbTree::allocate() {
+    if (free_list < 0) {
+        nodes.push_back(Node());
+        return (int)nodes.size() - 1;
+    }
+    int n = free_list;
+    free_list = nodes[n].parent;
+    nodes[n] = Node();
+    return n;
+}
+
+void AabbTree::release(int n) {
+    nodes[n].parent = free_list;
+    nodes[n].height = -1;
+    free_list = n;
+}
+
+void AabbTree::clear() {
+    nodes.clear();
+    root = free_list = -1;
+    leaves = 0;
+}
+
+AabbTree::Proxy AabbTree::insert(const Aabb& box, int user) {
+    int leaf = allocate();
+    nodes[leaf].box.lo = box.lo - glm::vec3(margin);
+    nodes[leaf].box.hi = box.hi + glm::vec3(margin);
+    nodes[leaf].user = user;
+    nodes[leaf].height = 0;
+    insert_leaf(leaf);
+    leaves++;
+    return leaf;
+}
+
+void AabbTree::remove(Proxy p) {
+    remove_leaf(p);
+    release(p);
+    leaves--;
+}
+
+bool AabbTree::move(Proxy p, const Aabb& box) {
+    if (contains(nodes[p].box, box)) return false;
+    remove_leaf(p);
+    nodes[p].box.lo = box.lo - glm::vec3(margin);
+    nodes[p].box.hi = box.hi + glm::vec3(margin);
+    insert_leaf(p);
+    return true;
+}
+
+// Спуск к месту вставки: в каждом узле сравнивается цена сделать лист
+// его соседом и цена спуститься в одного из детей (рост площади всех
+// узлов на пути).
+void AabbTree::insert_leaf(int leaf) {
+    if (root < 0) {
+        root = leaf;
+        nodes[leaf].parent = -1;
+        return;
+    }
+
+    Aabb box = nodes[leaf].box;
+    int index = root;
+    while (!nodes[index].leaf()) {
+        const Node& n = nodes[index];
+        float a = area(n.box);
+        float combined = area(merge(n.box, box));
+        float cost = 2.0f * combined;
+        float inheritance = 2.0f * (combined - a);
+
+        float child_cost[2];
+        int children[2] = { n.child1, n.child2 };
+        for (int c = 0; c < 2; c++) {
+            const Node& child = nodes[children[c]];
+            float grown = area(merge(child.box, box));
+            child_cost[c] = (child.leaf() ? grown : grown - area(child.box)) + inheritance;
+        }
+        if (cost < child_cost[0] && cost < child_cost[1]) break;
+        index = child_cost[0] < child_cost[1] ? children[0] : children[1];
+    }
+
+    int sibling = index;
+    int old_parent = nodes[sibling].parent;
+    int new_parent = allocate();
+    nodes[new_parent].parent = old_parent;
+    nodes[new_parent].box = merge(box, nodes[sibling].box);
+    nodes[new_parent].height = nodes[sibling].height + 1;
+    nodes[new_parent].child1 = sibling;
+    nodes[new_parent].child2 = leaf;
+    nodes[sibling].parent = new_parent;
+    nodes[leaf].parent = new_parent;
+    if (old_parent >= 0) {
+        if (nodes[old_parent].child1 == sibling) nodes[old_parent].child1 = new_parent;
+        else nodes[old_parent].child2 = new_parent;
+    }
+    else {
+        root = new_parent;
+    }
+    fix_upwards(nodes[leaf].parent);
+}
+
+void AabbTree::remove_leaf(int leaf) {
+    if (leaf == root) {
+        root = -1;
+        return;
+    }
+    int parent = nodes[leaf].parent;
+    int grand = nodes[parent].parent;
+    int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+    if (grand >= 0) {
+        if (nodes[grand].child1 == parent) nodes[grand].child1 = sibling;
+        else nodes[grand].child2 = sibling;
+        nodes[sibling].parent = grand;
+        release(parent);
+        fix_upwards(grand);
+    }
+    else {
+        root = sibling;
+        nodes[sibling].parent = -1;
+        release(parent);
+    }
+}
+
+void AabbTree::fix_upwards(int n) {
+    while (n >= 0) {
+        n = balance(n);
+        Node& node = nodes[n];
+        const Node& c1 = nodes[node.child1];
+        const Node& c2 = nodes[node.child2];
+        node.height = 1 + std::max(c1.height, c2.height);
+        node.box = merge(c1.box, c2.box);
+        n = node.parent;
+    }
+}
+
+// Поворот, если высоты поддеревьев узла a отличаются больше чем на 1:
+// более высокий ребёнок встаёт на место a. Возвращает новый корень
+// поддерева.
+int AabbTree::balance(int ia) {
+    Node& a = nodes[ia];
+    if (a.leaf() || a.height < 2) return ia;
+
+    int ib = a.child1, ic = a.child2;
+    Node& b = nodes[ib];
+    Node& c = nodes[ic];
+    int diff = c.height - b.height;
+    if (diff >= -1 && diff <= 1) return ia;
+
+    // up - поднимаемый ребёнок, other - второй ребёнок a
+    bool c_up = diff > 1;
+    int iup = c_up ? ic : ib;
+    Node& up = c_up ? c : b;
+    Node& other = c_up ? b : c;
+    int i1 = up.child1, i2 = up.child2;
+    Node& n1 = nodes[i1];
+    Node& n2 = nodes[i2];
+
+    up.child1 = ia;
+    up.parent = a.parent;
+    a.parent = iup;
+    if (up.parent >= 0) {
+        Node& p = nodes[up.parent];
+        if (p.child1 == ia) p.child1 = iup;
+        else p.child2 = iup;
+    }
+    else {
+        root = iup;
+    }
+
+    // более высокий внук остаётся у up, низкий переходит к a на место up
+    int keep = n1.height > n2.height ? i1 : i2;
+    int give = keep == i1 ? i2 : i1;
+    up.child2 = keep;
+    if (c_up) a.child2 = give;
+    else a.child1 = give;
+    nodes[give].parent = ia;
+
+    a.box = merge(other.box, nodes[give].box);
+    a.height = 1 + std::max(other.height, nodes[give].height);
+    up.box = merge(a.box, nodes[keep].box);
+    up.height = 1 + std::max(a.height, nodes[keep].height);
+    return iup;
+}
+
+void AabbTree::collect(int n, vector<int>& users) const {
+    int stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = n;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+        if (node.leaf()) {
+            users.push_back(node.user);
+            continue;
+        }
+        stack[top++] = node.child1;
+        stack[top++] = node.child2;
+    }
+}
+
+void AabbTree::query(const Aabb& box, vector<int>& users) const {
+    users.clear();
+    if (root < 0) return;
+    int stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = root;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+        if (!overlaps(node.box, box)) continue;
+        if (node.leaf()) {
+            users.push_back(node.user);
+            continue;
+        }
+        stack[top++] = node.child1;
+        stack[top++] = node.child2;
+    }
+}
+
+void AabbTree::query_frustum(const glm::mat4& vp, vector<int>& users, int subtree) const {
+    users.clear();
+    if (subtree < 0) subtree = root;
+    if (subtree < 0) return;
+
+    // плоскости пирамиды из строк матрицы (Gribb/Hartmann), внутрь - плюс
+    float planes[6][4];
+    for (int k = 0; k < 3; k++) {
+        for (int c = 0; c < 4; c++) {
+            planes[k * 2][c] = vp[c][3] + vp[c][k];
+            planes[k * 2 + 1][c] = vp[c][3] - vp[c][k];
+        }
+    }
+
+    // Вместе с узлом в стеке лежит маска плоскостей, которые он ещё
+    // пересекает: если узел целиком по внутреннюю сторону плоскости, его
+    // потомки с ней не проверяются.
+    int stack[STACK_SIZE];
+    unsigned masks[STACK_SIZE];
+    int top = 0;
+    stack[top] = subtree;
+    masks[top++] = 0x3f;
+    while (top > 0) {
+        --top;
+        int index = stack[top];
+        unsigned mask = masks[top];
+        const Node& node = nodes[index];
+        glm::vec3 center = (node.box.lo + node.box.hi) * 0.5f;
+        glm::vec3 extent = (node.box.hi - node.box.lo) * 0.5f;
+        bool outside = false;
+        for (int p = 0; p < 6 && !outside; p++) {
+            if (!(mask & (1u << p))) continue;
+            const float* pl = planes[p];
+            float d = pl[0] * center.x + pl[1] * center.y + pl[2] * center.z + pl[3];
+            float r = std::fabs(pl[0]) * extent.x + std::fabs(pl[1]) * extent.y + std::fabs(pl[2]) * extent.z;
+            if (d + r < 0.0f) outside = true;
+            else if (d - r >= 0.0f) mask &= ~(1u << p);
+        }
+        if (outside) continue;
+        if (node.leaf()) {
+            users.push_back(node.user);
+        }
+        else if (mask == 0) {
+            collect(index, users);
+        }
+        else {
+            stack[top] = node.child1;
+            masks[top++] = mask;
+            stack[top] = node.child2;
+            masks[top++] = mask;
+        }
+    }
+}
+
+void AabbTree::split(size_t count, vector<int>& subtrees) const {
+    subtrees.clear();
+    if (root < 0) return;
+    subtrees.push_back(root);
+    while (subtrees.size() < count) {
+        auto highest = std::max_element(subtrees.begin(), subtrees.end(),
+            [this](int a, int b) { return nodes[a].height < nodes[b].height; });
+        const Node& node = nodes[*highest];
+        if (node.leaf()) break;
+        *highest = node.child1;
+        subtrees.push_back(node.child2);
+    }
+}
+
+int AabbTree::ray_cast(const glm::vec3& origin, const glm::vec3& dir, float max_t, const RayTest& exact, float* t_hit) const {
+    glm::vec3 inv(1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z);
+    float t;
+    if (root < 0 || !ray_aabb(origin, inv, nodes[root].box, max_t, &t)) return -1;
+    int best = -1;
+    float best_t = max_t;
+
+    // в стеке узлы, уже задетые лучом, с параметром входа в их AABB
+    int stack[STACK_SIZE];
+    float enter[STACK_SIZE];
+    int top = 0;
+    stack[top] = root;
+    enter[top++] = t;
+    while (top > 0) {
+        --top;
+        if (enter[top] > best_t) continue; // найденное ближе всей ветви
+        const Node& node = nodes[stack[top]];
+        if (node.leaf()) {
+            t = exact ? exact(node.user) : enter[top];
+            if (t >= 0.0f && t <= best_t) {
+                best = node.user;
+                best_t = t;
+            }
+            continue;
+        }
+        // ближний ребёнок кладётся последним и обходится первым
+        float t1, t2;
+        bool h1 = ray_aabb(origin, inv, nodes[node.child1].box, best_t, &t1);
+        bool h2 = ray_aabb(origin, inv, nodes[node.child2].box, best_t, &t2);
+        if (h1 && h2 && t1 < t2) {
+            stack[top] = node.child2; enter[top++] = t2;
+            stack[top] = node.child1; enter[top++] = t1;
+        }
+        else {
+            if (h1) { stack[top] = node.child1; enter[top++] = t1; }
+            if (h2) { stack[top] = node.child2; enter[top++] = t2; }
+        }
+    }
+    if (best >= 0 && t_hit) *t_hit = best_t;
+    return best;
+}
@@ -0,0 +1,116 @@
+﻿#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <functional>
+
+using namespace std;
+
+/// <summary>
+/// Ограничивающий параллелепипед, выровненный по осям.
+/// </summary>
+struct Aabb {
+    glm::vec3 lo = glm::vec3(0.0f);
+    glm::vec3 hi = glm::vec3(0.0f);
+};
+
+/// <summary>
+/// Пересечение луча origin + t * dir (inv_dir = 1 / dir) с box при 0 &lt;= t &lt;= max_t
+/// (метод плоскостей).
+/// </summary>
+/// <param name="inv_dir">1 / направление луча, покомпонентно.</param>
+/// <param name="t">Параметр точки входа (0, если начало луча внутри).</param>
+bool ray_aabb(const glm::vec3& origin, const glm::vec3& inv_dir, const Aabb& box, float max_t, float* t);
+
+/// <summary>
+/// Динамическое дерево AABB (иерархия ограничивающих объёмов). Листья
+/// хранят "толстые" AABB с запасом margin: пока объект движется в их
+/// пределах, move() не трогает дерево. Лист вставляется туда, где
+/// меньше всего растёт суммарная площадь поверхности узлов, а поворотами
+/// по пути вверх дерево держится сбалансированным (высота ~ log n), так
+/// что запросы по лучу, области и пирамиде видимости обходят только
+/// ветви, которые их касаются.
+/// </summary>
+class AabbTree
+{
+public:
+    typedef int Proxy;
+
+    /// <param name="margin">Запас толстых AABB по каждой оси.</param>
+    explicit AabbTree(float margin = 0.05f) : margin(margin) {}
+
+    /// <summary>
+    /// Добавление объекта user с границами box.
+    /// </summary>
+    Proxy insert(const Aabb& box, int user);
+    void remove(Proxy p);
+
+    /// <summary>
+    /// Новые границы объекта. Дерево перестраивается, только если box
+    /// вышел за толстый AABB листа.
+    /// </summary>
+    /// <returns>true, если лист был переставлен.</returns>
+    bool move(Proxy p, const Aabb& box);
+
+    void clear();
+    int user(Proxy p) const { return nodes[p].user; }
+    const Aabb& fat_box(Proxy p) const { return nodes[p].box; }
+    int height() const { return root < 0 ? 0 : nodes[root].height; }
+    size_t size() const { return leaves; }
+
+    /// <summary>
+    /// Объекты, чьи толстые AABB пересекают box.
+    /// </summary>
+    void query(const Aabb& box, vector<int>& users) const;
+
+    /// <summary>
+    /// Объекты, чьи толстые AABB пересекают пирамиду видимости view_proj.
+    /// Ветви целиком внутри пирамиды добавляются без проверки листьев.
+    /// </summary>
+    /// <param name="subtree">Обойти только это поддерево (см. split), -1 - всё дерево.</param>
+    void query_frustum(const glm::mat4& view_proj, vector<int>& users, int subtree = -1) const;
+
+    /// <summary>
+    /// Деление дерева на не больше count поддеревьев, вместе покрывающих
+    /// все листья, для параллельного обхода: раскрываются самые высокие.
+    /// </summary>
+    void split(size_t count, vector<int>& subtrees) const;
+
+    /// <summary>
+    /// Проверка объекта лучом: параметр t точки попадания или
+    /// отрицательное число, если луч объект не задел.
+    /// </summary>
+    typedef function<float(int user)> RayTest;
+
+    /// <summary>
+    /// Ближайший объект на луче origin + dir * t, 0 &lt;= t &lt;= max_t.
+    /// Листья, чей толстый AABB задет лучом, проверяются через exact
+    /// (пустой - попаданием считается вход в толстый AABB); дальше
+    /// найденного ветви не обходятся.
+    /// </summary>
+    /// <param name="t_hit">Параметр точки попадания.</param>
+    /// <returns>user найденного объекта или -1.</returns>
+    int ray_cast(const glm::vec3& origin, const glm::vec3& dir, float max_t, const RayTest& exact, float* t_hit) const;
+private:
+    struct Node {
+        Aabb box;
+        int parent = -1;        // для свободных узлов - следующий свободный
+        int child1 = -1, child2 = -1;
+        int height = 0;         // 0 - лист, -1 - свободный узел
+        int user = -1;
+        bool leaf() const { return child1 < 0; }
+    };
+
+    int allocate();
+    void release(int n);
+    void insert_leaf(int leaf);
+    void remove_leaf(int leaf);
+    int balance(int a);
+    void fix_upwards(int n);
+    void collect(int n, vector<int>& users) const;
+
+    vector<Node> nodes;
+    int root = -1;
+    int free_list = -1;
+    size_t leaves = 0;
+    float margin;
+};
@@ -0,0 +1,44 @@
+﻿// AssetIOSystem.cpp
+#include "AssetIOSystem.h"
+#include <cstring>
+#include <algorithm>
+
+size_t AssetIOStream::Read(void* buffer, size_t size, size_t count) {
+    if (!size || !count) return 0;
+    if (progress && progress->cancelled) return 0;
+    size_t left = blob.size - pos;
+    size_t n = std::min(count, left / size);
+    memcpy(buffer, blob.data + pos, n * size);
+    pos += n * size;
+    if (progress) progress->read += n * size;
+    return n;
+}
+
+aiReturn AssetIOStream::Seek(size_t offset, aiOrigin origin) {
+    size_t target;
+    switch (origin) {
+    case aiOrigin_SET: target = offset; break;
+    case aiOrigin_CUR: target = pos + offset; break;
+    // смещение от конца отрицательное и приходит приведённым к size_t:
+    // сумма переполняется и даёт позицию до конца
+    case aiOrigin_END: target = blob.size + offset; break;
+    default: return aiReturn_FAILURE;
+    }
+    if (target > blob.size) return aiReturn_FAILURE;
+    pos = target;
+    return aiReturn_SUCCESS;
+}
+
+bool AssetIOSystem::Exists(const char* file) const {
+    return AssetExists(file);
+}
+
+Assimp::IOStream* AssetIOSystem::Open(const char* file, const char* mode) {
+    // ресурсы только читаются
+    if (strchr(mode, 'w') || strchr(mode, 'a') || strchr(mode, '+')) return nullptr;
+    if (progress && progress->cancelled) return nullptr;
+    AssetBlob blob = LoadAsset(file);
+    if (!blob) return nullptr;
+    if (progress) progress->total += blob.size;
+    return new AssetIOStream(blob, progress);
+}
@@ -0,0 +1,57 @@
+﻿#pragma once
+#include "Assets.h"
+#include <assimp/IOSystem.hpp>
+#include <assimp/IOStream.hpp>
+#include <atomic>
+
+/// <summary>
+/// Счётчики чтения для оценки прогресса и флаг отмены. После отмены
+/// Read возвращает 0, и загрузчик Assimp бросает разбор на первом же
+/// чтении, не дожидаясь конца файла.
+/// </summary>
+struct IOProgress {
+    std::atomic<size_t> total{ 0 };
+    std::atomic<size_t> read{ 0 };
+    std::atomic<bool> cancelled{ false };
+};
+
+/// <summary>
+/// Поток Assimp поверх AssetBlob: чтение идёт прямо из отображённого файла,
+/// записи в архиве или встроенного ресурса, без промежуточного буфера.
+/// </summary>
+class AssetIOStream : public Assimp::IOStream
+{
+public:
+    AssetIOStream(const AssetBlob& blob, IOProgress* progress) : blob(blob), progress(progress) {}
+
+    size_t Read(void* buffer, size_t size, size_t count) override;
+    size_t Write(const void*, size_t, size_t) override { return 0; }
+    aiReturn Seek(size_t offset, aiOrigin origin) override;
+    size_t Tell() const override { return pos; }
+    size_t FileSize() const override { return blob.size; }
+    void Flush() override {}
+private:
+    AssetBlob blob;
+    size_t pos = 0;
+    IOProgress* progress;
+};
+
+/// <summary>
+/// Файловая система для Assimp::Importer через LoadAsset. Сопутствующие
+/// файлы (MTL к OBJ, текстуры, внешние буферы) ищутся там же, где и сама
+/// модель: в каталоге ресурсов, архивах .pack и встроенной таблице.
+/// Importer удаляет объект сам (см. SetIOHandler).
+/// </summary>
+class AssetIOSystem : public Assimp::IOSystem
+{
+public:
+    /// <param name="progress">Куда сообщать о прочитанном (может быть nullptr).</param>
+    explicit AssetIOSystem(IOProgress* progress = nullptr) : progress(progress) {}
+
+    bool Exists(const char* file) const override;
+    char getOsSeparator() const override { return '/'; }
+    Assimp::IOStream* Open(const char* file, const char* mode = "rb") override;
+    void Close(Assimp::IOStream* file) override { delete file; }
+private:
+    IOProgress* progress;
+};
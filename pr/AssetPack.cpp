@@ -0,0 +1,122 @@
+﻿// AssetPack.cpp
+#include "AssetPack.h"
+#include "Lz4.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+bool AssetPack::open(const char* path) {
+    auto f = make_shared<MappedFile>();
+    if (!f->open(path)) return false;
+
+    const unsigned char* data = f->data();
+    size_t size = f->size();
+    PackHeader h;
+    if (size < sizeof(h)) return false;
+    memcpy(&h, data, sizeof(h));
+    if (h.magic != PACK_MAGIC || h.version != PACK_VERSION) {
+        std::cerr << "Asset pack " << path << " has wrong format" << std::endl;
+        return false;
+    }
+
+    size_t names_at = sizeof(PackHeader) + (size_t)h.entry_count * sizeof(PackEntry);
+    if (names_at + h.names_size > size) return false;
+    const PackEntry* e = (const PackEntry*)(data + sizeof(PackHeader));
+    for (uint32_t i = 0; i < h.entry_count; i++) {
+        if ((uint64_t)e[i].name_offset + e[i].name_size > h.names_size) return false;
+        if (e[i].offset > size || e[i].size > size - e[i].offset) return false;
+        if (!(e[i].flags & PACK_LZ4) && e[i].size != e[i].raw_size) return false;
+    }
+
+    file = f;
+    entries = e;
+    names = (const char*)(data + names_at);
+    count = h.entry_count;
+    file_path = path;
+    return true;
+}
+
+string AssetPack::name_of(const PackEntry& e) const {
+    return string(names + e.name_offset, e.name_size);
+}
+
+const PackEntry* AssetPack::find(const string& name) const {
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        const PackEntry& e = entries[mid];
+        int c = name.compare(0, string::npos, names + e.name_offset, e.name_size);
+        if (c == 0) return &e;
+        if (c < 0) hi = mid;
+        else lo = mid + 1;
+    }
+    return nullptr;
+}
+
+AssetBlob AssetPack::read(const PackEntry& e) const {
+    AssetBlob blob;
+    const unsigned char* src = file->data() + e.offset;
+    if (!(e.flags & PACK_LZ4)) {
+        blob.data = src;
+        blob.size = (size_t)e.size;
+        blob.owner = file;
+        return blob;
+    }
+
+    auto raw = make_shared<vector<unsigned char>>((size_t)e.raw_size);
+    if (!Lz4Decompress(src, (size_t)e.size, raw->data(), raw->size())) {
+        std::cerr << "Asset pack " << file_path << ": entry " << name_of(e) << " is corrupted" << std::endl;
+        return blob;
+    }
+    blob.data = raw->data();
+    blob.size = raw->size();
+    blob.owner = raw;
+    return blob;
+}
+
+vector<unsigned char> BuildAssetPack(vector<PackInput> inputs) {
+    std::sort(inputs.begin(), inputs.end(),
+        [](const PackInput& a, const PackInput& b) { return a.name < b.name; });
+
+    PackHeader h = {};
+    h.magic = PACK_MAGIC;
+    h.version = PACK_VERSION;
+    h.entry_count = (uint32_t)inputs.size();
+
+    vector<PackEntry> toc(inputs.size());
+    string names;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        toc[i].name_offset = (uint32_t)names.size();
+        toc[i].name_size = (uint32_t)inputs[i].name.size();
+        names += inputs[i].name;
+    }
+    h.names_size = (uint32_t)names.size();
+
+    size_t at = sizeof(PackHeader) + toc.size() * sizeof(PackEntry) + names.size();
+    vector<vector<unsigned char>> stored(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+        const vector<unsigned char>& raw = inputs[i].data;
+        toc[i].raw_size = raw.size();
+        toc[i].hash = HashBytes(raw.data(), raw.size());
+        if (inputs[i].compress && !raw.empty()) {
+            vector<unsigned char> z = Lz4Compress(raw.data(), raw.size());
+            if (z.size() + raw.size() / 8 <= raw.size()) {
+                stored[i] = std::move(z);
+                toc[i].flags |= PACK_LZ4;
+            }
+        }
+        if (!(toc[i].flags & PACK_LZ4)) stored[i] = raw;
+        at = (at + PACK_ALIGN - 1) & ~(size_t)(PACK_ALIGN - 1);
+        toc[i].offset = at;
+        toc[i].size = stored[i].size();
+        at += stored[i].size();
+    }
+
+    vector<unsigned char> out(at, 0);
+    memcpy(out.data(), &h, sizeof(h));
+    if (!toc.empty()) memcpy(out.data() + sizeof(h), toc.data(), toc.size() * sizeof(PackEntry));
+    memcpy(out.data() + sizeof(h) + toc.size() * sizeof(PackEntry), names.data(), names.size());
+    for (size_t i = 0; i < inputs.size(); i++)
+        if (!stored[i].empty()) memcpy(out.data() + toc[i].offset, stored[i].data(), stored[i].size());
+    return out;
+}
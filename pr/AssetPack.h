@@ -0,0 +1,91 @@
+﻿#pragma once
+#include "Assets.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+
+using namespace std;
+
+// Формат архива .pack:
+//   PackHeader
+//   PackEntry[entry_count]  - отсортированы по имени для двоичного поиска
+//   имена записей подряд, без нулей в конце
+//   данные записей, каждая выровнена на PACK_ALIGN байт
+// Несжатые записи отдаются прямо из отображения файла; записи с флагом
+// PACK_LZ4 распаковываются при каждом чтении.
+
+const uint32_t PACK_MAGIC = 0x4B434150; // "PACK"
+const uint32_t PACK_VERSION = 1;
+const uint32_t PACK_ALIGN = 16;
+const uint32_t PACK_LZ4 = 1;
+
+struct PackHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t names_size;
+};
+
+struct PackEntry {
+    uint64_t offset;
+    uint64_t size;      // размер в архиве
+    uint64_t raw_size;  // размер после распаковки
+    uint64_t hash;      // HashBytes распакованных данных
+    uint32_t name_offset;
+    uint32_t name_size;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+/// <summary>
+/// Открытый архив ресурсов. Файл отображается в память целиком, ОС
+/// подгружает только те страницы, к которым было обращение.
+/// </summary>
+class AssetPack
+{
+public:
+    /// <summary>
+    /// Отображение архива и проверка оглавления.
+    /// </summary>
+    /// <returns>false, если файла нет или он повреждён.</returns>
+    bool open(const char* path);
+
+    /// <summary>
+    /// Поиск записи по нормализованному имени.
+    /// </summary>
+    const PackEntry* find(const string& name) const;
+
+    /// <summary>
+    /// Содержимое записи (распакованное, если она сжата).
+    /// </summary>
+    AssetBlob read(const PackEntry& entry) const;
+
+    const string& path() const { return file_path; }
+    size_t size() const { return count; }
+private:
+    string name_of(const PackEntry& e) const;
+
+    shared_ptr<MappedFile> file;
+    const PackEntry* entries = nullptr;
+    const char* names = nullptr;
+    size_t count = 0;
+    string file_path;
+};
+
+/// <summary>
+/// Исходные данные одной записи для сборки архива.
+/// </summary>
+struct PackInput {
+    string name;
+    vector<unsigned char> data;
+    bool compress = false;
+};
+
+/// <summary>
+/// Сборка архива. Сжатие применяется к записи, только если оно даёт
+/// выигрыш не меньше 1/8 размера - иначе запись хранится как есть и
+/// читается без копирования.
+/// </summary>
+vector<unsigned char> BuildAssetPack(vector<PackInput> inputs);
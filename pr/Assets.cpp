@@ -0,0 +1,173 @@
+﻿// Assets.cpp
+#include "Assets.h"
+#include "MappedFile.h"
+#include "AssetPack.h"
+#include <mutex>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+
+#if __has_include("generated/embedded_assets.h")
+#include "generated/embedded_assets.h"
+#else
+namespace embedded {
+    constexpr EmbeddedAsset table[] = { { nullptr, nullptr, 0 } };
+}
+#endif
+
+namespace {
+    string asset_dir;
+
+    // ресурсы читаются и из рабочих потоков, поэтому переменная окружения
+    // разбирается один раз при первом обращении (инициализация static потокобезопасна)
+    const string& override_dir() {
+        static const bool from_env = [] {
+            const char* env = std::getenv("PR_ASSET_DIR");
+            if (env && *env && asset_dir.empty()) SetAssetDirectory(env);
+            return true;
+        }();
+        (void)from_env;
+        return asset_dir;
+    }
+
+    // подключённые архивы; более поздние перекрывают ранние
+    mutex packs_lock;
+    vector<shared_ptr<AssetPack>> packs;
+
+    // assets.pack рядом с программой (или PR_ASSET_PACK) подключается сам,
+    // с наименьшим приоритетом, при первом обращении к архивам
+    void mount_default_pack() {
+        static const bool mounted = [] {
+            const char* env = std::getenv("PR_ASSET_PACK");
+            auto pack = make_shared<AssetPack>();
+            if (!pack->open(env && *env ? env : "assets.pack")) return false;
+            lock_guard<mutex> g(packs_lock);
+            packs.insert(packs.begin(), pack);
+            return true;
+        }();
+        (void)mounted;
+    }
+
+    AssetBlob read_packed(const string& name) {
+        mount_default_pack();
+        lock_guard<mutex> g(packs_lock);
+        for (auto it = packs.rbegin(); it != packs.rend(); ++it)
+            if (const PackEntry* e = (*it)->find(name)) return (*it)->read(*e);
+        return AssetBlob();
+    }
+
+    bool in_pack(const string& name) {
+        mount_default_pack();
+        lock_guard<mutex> g(packs_lock);
+        for (auto& p : packs)
+            if (p->find(name)) return true;
+        return false;
+    }
+
+    // Имя ресурса без "\\", "." и "dir/..": Assimp склеивает пути
+    // сопутствующих файлов вида "models/./textures/../phone.mtl".
+    string normalize(const char* name) {
+        string n = name;
+        for (char& c : n) if (c == '\\') c = '/';
+        vector<string> parts;
+        size_t start = 0;
+        bool absolute = !n.empty() && n[0] == '/';
+        while (start <= n.size()) {
+            size_t end = n.find('/', start);
+            if (end == string::npos) end = n.size();
+            string part = n.substr(start, end - start);
+            if (part == "..") {
+                if (!parts.empty() && parts.back() != "..") parts.pop_back();
+                else parts.push_back(part);
+            }
+            else if (!part.empty() && part != ".") {
+                parts.push_back(part);
+            }
+            start = end + 1;
+        }
+        string out = absolute ? "/" : "";
+        for (size_t i = 0; i < parts.size(); i++) {
+            if (i) out += '/';
+            out += parts[i];
+        }
+        return out;
+    }
+
+    const EmbeddedAsset* find_embedded(const string& name) {
+        for (const EmbeddedAsset* a = embedded::table; a->name; a++)
+            if (name == a->name) return a;
+        return nullptr;
+    }
+
+    // Файлы с диска отображаются в память: blob указывает прямо в
+    // отображение и держит его, пока жив.
+    AssetBlob read_file(const string& path) {
+        AssetBlob blob;
+        auto file = make_shared<MappedFile>();
+        if (!file->open(path.c_str())) return blob;
+        blob.data = file->data();
+        blob.size = file->size();
+        blob.owner = file;
+        return blob;
+    }
+
+    bool file_exists(const string& path) {
+        FILE* f = std::fopen(path.c_str(), "rb");
+        if (f) std::fclose(f);
+        return f != nullptr;
+    }
+
+    AssetBlob embedded_blob(const EmbeddedAsset* a) {
+        AssetBlob blob;
+        blob.data = a->data;
+        blob.size = a->size;
+        return blob;
+    }
+}
+
+void SetAssetDirectory(const string& dir) {
+    asset_dir = dir;
+    if (!asset_dir.empty() && asset_dir.back() != '/' && asset_dir.back() != '\\')
+        asset_dir += '/';
+}
+
+bool MountAssetPack(const char* path) {
+    auto pack = make_shared<AssetPack>();
+    if (!pack->open(path)) return false;
+    lock_guard<mutex> g(packs_lock);
+    packs.push_back(pack);
+    return true;
+}
+
+AssetBlob LoadAsset(const char* name) {
+    string n = normalize(name);
+    if (!override_dir().empty()) {
+        AssetBlob blob = read_file(asset_dir + n);
+        if (blob) return blob;
+    }
+#ifdef ASSETS_PREFER_DISK
+    if (AssetBlob blob = read_file(n)) return blob;
+    if (AssetBlob blob = read_packed(n)) return blob;
+    if (const EmbeddedAsset* a = find_embedded(n)) return embedded_blob(a);
+    return AssetBlob();
+#else
+    if (AssetBlob blob = read_packed(n)) return blob;
+    if (const EmbeddedAsset* a = find_embedded(n)) return embedded_blob(a);
+    return read_file(n);
+#endif
+}
+
+bool AssetExists(const char* name) {
+    string n = normalize(name);
+    if (!override_dir().empty() && file_exists(asset_dir + n)) return true;
+    return in_pack(n) || find_embedded(n) != nullptr || file_exists(n);
+}
+
+uint64_t HashBytes(const unsigned char* data, size_t size) {
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++) {
+        h ^= data[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
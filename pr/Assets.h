@@ -0,0 +1,62 @@
+﻿#pragma once
+#include <string>
+#include <memory>
+#include <cstdint>
+
+using namespace std;
+
+/// <summary>
+/// Запись таблицы встроенных ресурсов (генерируется tools/embed_assets.py).
+/// </summary>
+struct EmbeddedAsset {
+    const char* name;
+    const unsigned char* data;
+    size_t size;
+};
+
+/// <summary>
+/// Содержимое ресурса. Встроенные данные живут всё время работы программы,
+/// файлы с диска отображены в память и удерживаются через owner.
+/// </summary>
+struct AssetBlob {
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    shared_ptr<const void> owner;
+
+    explicit operator bool() const { return data != nullptr; }
+    string str() const { return string((const char*)data, size); }
+};
+
+/// <summary>
+/// Загрузка ресурса по имени. Порядок поиска: каталог из SetAssetDirectory
+/// (или переменной окружения PR_ASSET_DIR), подключённые архивы .pack,
+/// встроенная таблица, текущий каталог. При ASSETS_PREFER_DISK текущий
+/// каталог проверяется раньше архивов и встроенной таблицы, чтобы правки
+/// шейдеров подхватывались без пересборки.
+/// </summary>
+/// <param name="name">Путь относительно каталога проекта.</param>
+/// <returns>Данные ресурса; пустой AssetBlob, если ресурс не найден.</returns>
+AssetBlob LoadAsset(const char* name);
+
+/// <summary>
+/// Проверка наличия ресурса без чтения.
+/// </summary>
+bool AssetExists(const char* name);
+
+/// <summary>
+/// Подключение архива ресурсов (см. AssetPack.h). Архив assets.pack из
+/// текущего каталога или из PR_ASSET_PACK подключается автоматически.
+/// </summary>
+/// <returns>false, если архив не открылся.</returns>
+bool MountAssetPack(const char* path);
+
+/// <summary>
+/// Каталог, из которого ресурсы читаются в первую очередь (пустая строка -
+/// отключить).
+/// </summary>
+void SetAssetDirectory(const string& dir);
+
+/// <summary>
+/// 64-битный хэш FNV-1a содержимого (для поиска одинаковых ресурсов).
+/// </summary>
+uint64_t HashBytes(const unsigned char* data, size_t size);
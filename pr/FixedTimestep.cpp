@@ -0,0 +1,24 @@
+﻿// FixedTimestep.cpp
+#include "FixedTimestep.h"
+
+void FixedTimestep::reset(double now) {
+    last = now;
+    accumulator = 0.0;
+}
+
+int FixedTimestep::advance(double now) {
+    double elapsed = now - last;
+    last = now;
+    if (elapsed > 0.0) accumulator += elapsed;
+
+    int n = (int)(accumulator / dt);
+    if (n > max_ticks) {
+        // лишнее время отбрасывается, доля шага сохраняется
+        accumulator -= (n - max_ticks) * dt;
+        n = max_ticks;
+    }
+    accumulator -= n * dt;
+    if (accumulator < 0.0) accumulator = 0.0;
+    ticks += n;
+    return n;
+}
@@ -0,0 +1,44 @@
+﻿#pragma once
+
+/// <summary>
+/// Часы симуляции с постоянным шагом. Прошедшее реальное время копится и
+/// расходуется целыми шагами, остаток даёт долю alpha для интерполяции
+/// между двумя последними состояниями при отрисовке. Симуляция тогда не
+/// зависит от частоты кадров, а медленный кадр лишь добавляет шагов.
+/// </summary>
+class FixedTimestep
+{
+public:
+    /// <param name="step">Длина шага в секундах.</param>
+    /// <param name="max_ticks">Предел шагов за кадр: после долгой паузы
+    /// (загрузка, отладчик) симуляция не догоняет всё упущенное время.</param>
+    explicit FixedTimestep(double step = 1.0 / 120.0, int max_ticks = 8) : dt(step), max_ticks(max_ticks) {}
+
+    /// <summary>
+    /// Начало отсчёта; накопленное время сбрасывается.
+    /// </summary>
+    void reset(double now);
+
+    /// <summary>
+    /// Учёт времени, прошедшего до now.
+    /// </summary>
+    /// <returns>Сколько шагов симуляции выполнить в этом кадре.</returns>
+    int advance(double now);
+
+    double step() const { return dt; }
+    /// <summary>
+    /// Доля шага, накопленная сверх выполненных шагов (0..1).
+    /// </summary>
+    float alpha() const { return (float)(accumulator / dt); }
+    /// <summary>
+    /// Время симуляции: число выполненных шагов, умноженное на шаг.
+    /// </summary>
+    double time() const { return ticks * dt; }
+    long long tick_count() const { return ticks; }
+private:
+    double dt;
+    int max_ticks;
+    double last = 0.0;
+    double accumulator = 0.0;
+    long long ticks = 0;
+};
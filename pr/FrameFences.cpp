@@ -0,0 +1,63 @@
+﻿// FrameFences.cpp
+#include "FrameFences.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+
+void FrameFences::set_max_in_flight(int n) {
+    max_frames = std::min(std::max(n, 1), size());
+}
+
+bool FrameFences::complete(Fence& f, bool wait) {
+    if (!f.sync) return true;
+    if (wait) {
+        // первая попытка сбрасывает команды, чтобы забор точно дошёл до GPU
+        GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        while (glClientWaitSync(f.sync, flags, 1000000) == GL_TIMEOUT_EXPIRED) flags = 0;
+    }
+    else if (glClientWaitSync(f.sync, 0, 0) == GL_TIMEOUT_EXPIRED) {
+        return false;
+    }
+    double latency = (glfwGetTime() - f.input_time) * 1000.0;
+    latency_sum += latency;
+    latency_max = std::max(latency_max, latency);
+    latency_count++;
+    glDeleteSync(f.sync);
+    f.sync = nullptr;
+    return true;
+}
+
+void FrameFences::signal(uint64_t frame, double input_time) {
+    Fence& f = fences[frame % fences.size()];
+    complete(f, true); // кадр frame - size(): limit() обычно уже дождался его
+    f.sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    f.frame = frame;
+    f.input_time = input_time;
+}
+
+void FrameFences::limit(uint64_t frame) {
+    // GPU выполняет кадры по порядку: отмечаем от старого к новому
+    uint64_t keep = (uint64_t)max_frames - 1;
+    for (uint64_t back = (uint64_t)size() - 1; ; back--) {
+        if (back <= frame) {
+            Fence& f = fences[(frame - back) % fences.size()];
+            if (f.sync && f.frame == frame - back && !complete(f, back >= keep)) break;
+        }
+        if (back == 0) break;
+    }
+}
+
+bool FrameFences::take_latency(double* average_ms, double* max_ms) {
+    if (latency_count == 0) return false;
+    *average_ms = latency_sum / latency_count;
+    *max_ms = latency_max;
+    latency_sum = latency_max = 0.0;
+    latency_count = 0;
+    return true;
+}
+
+void FrameFences::release() {
+    for (Fence& f : fences) {
+        if (f.sync) glDeleteSync(f.sync);
+        f.sync = nullptr;
+    }
+}
@@ -0,0 +1,65 @@
+﻿#pragma once
+#include <GL/glew.h>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+/// <summary>
+/// Заборы GL после каждого кадра и ограничение числа кадров, которые
+/// драйвер держит в очереди. После отправки кадра signal() ставит забор,
+/// limit() ждёт, пока GPU закончит кадр, отстоящий на max_in_flight() - 1
+/// назад: 1 - каждый кадр дорисовывается до чтения ввода следующего
+/// (меньше задержка), size() - самая длинная очередь (больше кадров в
+/// секунду). Для каждого кадра запоминается время снятия ввода, и по
+/// срабатыванию забора считается задержка от ввода до готового кадра.
+/// Все методы вызываются в потоке с GL контекстом.
+/// </summary>
+class FrameFences
+{
+public:
+    /// <param name="count">Наборов данных кадра; больше кадров в полёте не бывает.</param>
+    explicit FrameFences(int count = 3) : fences(count), max_frames(count) {}
+
+    int size() const { return (int)fences.size(); }
+    int max_in_flight() const { return max_frames; }
+    void set_max_in_flight(int n);
+
+    /// <summary>
+    /// Забор после команд кадра frame (после SwapBuffers).
+    /// </summary>
+    /// <param name="input_time">Время снятия ввода для кадра (glfwGetTime).</param>
+    void signal(uint64_t frame, double input_time);
+
+    /// <summary>
+    /// Ожидание кадра frame + 1 - max_in_flight() и отметка всех уже
+    /// завершённых кадров.
+    /// </summary>
+    void limit(uint64_t frame);
+
+    /// <summary>
+    /// Средняя и наибольшая задержка от ввода до готового кадра с прошлого
+    /// вызова, мс; счётчики сбрасываются.
+    /// </summary>
+    /// <returns>false, если ни один кадр ещё не завершился.</returns>
+    bool take_latency(double* average_ms, double* max_ms);
+
+    /// <summary>
+    /// Удаление всех заборов (до разрушения контекста).
+    /// </summary>
+    void release();
+private:
+    struct Fence {
+        GLsync sync = nullptr;
+        uint64_t frame = 0;
+        double input_time = 0.0;
+    };
+
+    // true, если забор сработал (или его нет); с wait - ждёт его
+    bool complete(Fence& f, bool wait);
+
+    vector<Fence> fences;   // кадр frame лежит в fences[frame % size()]
+    int max_frames;
+    double latency_sum = 0.0, latency_max = 0.0;
+    int latency_count = 0;
+};
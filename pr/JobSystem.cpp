@@ -0,0 +1,278 @@
+﻿// JobSystem.cpp
+#include "JobSystem.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+    // номер потока в пуле, которому он принадлежит (0 - поток вне пула)
+    thread_local const JobSystem* current_pool = nullptr;
+    thread_local int current_index = 0;
+    // поток выполняет задачу, и её время уже идёт в busy_ns
+    thread_local bool in_task = false;
+}
+
+JobSystem::JobSystem(int threads) {
+    if (threads <= 0) threads = std::max(1, (int)thread::hardware_concurrency() - 1);
+    epoch = stats_since = chrono::steady_clock::now();
+    for (int i = 0; i <= threads; i++) {
+        queues.push_back(make_unique<WorkQueue>());
+        busy_ns.push_back(make_unique<atomic<int64_t>>(0));
+    }
+    for (int i = 0; i < threads; i++)
+        workers.push_back(thread(&JobSystem::worker_main, this, i + 1));
+}
+
+JobSystem::~JobSystem() {
+    shutdown();
+}
+
+double JobSystem::now_ms() const {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - epoch).count();
+}
+
+JobSystem::JobId JobSystem::add(const string& name, function<void()> fn, const vector<JobId>& deps, bool main_thread) {
+    lock_guard<mutex> g(lock);
+    if (jobs.empty()) epoch = chrono::steady_clock::now();
+    JobId id = (JobId)jobs.size();
+    jobs.push_back(Job());
+    Job& job = jobs.back();
+    job.name = name;
+    job.fn = std::move(fn);
+    job.main_thread = main_thread;
+    for (JobId d : deps) {
+        if (d < 0 || d >= id || jobs[d].done) continue;
+        jobs[d].dependents.push_back(&job);
+        job.waiting++;
+    }
+    unfinished++;
+    if (job.waiting == 0) make_ready(&job);
+    return id;
+}
+
+// вызывается под lock
+void JobSystem::make_ready(Job* job) {
+    if (job->main_thread) {
+        ready_main.push_back(job);
+        progress.notify_all();
+    }
+    else {
+        Task t;
+        t.job = job;
+        push(std::move(t));
+    }
+}
+
+void JobSystem::push(Task t) {
+    int q = current_pool == this ? current_index : 0;
+    {
+        lock_guard<mutex> g(queues[q]->lock);
+        queues[q]->tasks.push_back(std::move(t));
+    }
+    {
+        // под sleep_lock, чтобы засыпающий поток не пропустил пробуждение
+        lock_guard<mutex> g(sleep_lock);
+        queued++;
+    }
+    wake.notify_one();
+}
+
+// своя очередь - с конца
+bool JobSystem::pop(int thread, Task& t) {
+    WorkQueue& q = *queues[thread];
+    lock_guard<mutex> g(q.lock);
+    if (q.tasks.empty()) return false;
+    t = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    queued--;
+    return true;
+}
+
+// чужие очереди - с начала, начиная со следующего потока
+bool JobSystem::steal(int thread, Task& t) {
+    size_t n = queues.size();
+    for (size_t k = 1; k < n; k++) {
+        WorkQueue& q = *queues[(thread + k) % n];
+        lock_guard<mutex> g(q.lock);
+        if (q.tasks.empty()) continue;
+        t = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        queued--;
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::run(const Task& t, int thread) {
+    auto start = chrono::steady_clock::now();
+    in_task = true;
+    if (t.job) run_job(t.job, thread);
+    else run_loop(*t.loop);
+    in_task = false;
+    *busy_ns[thread] += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+}
+
+void JobSystem::run_job(Job* job, int thread) {
+    function<void()> fn;
+    {
+        lock_guard<mutex> g(lock);
+        job->thread = thread;
+        job->start = now_ms();
+        fn = std::move(job->fn);
+    }
+    fn();
+    finish(job);
+}
+
+void JobSystem::finish(Job* job) {
+    lock_guard<mutex> g(lock);
+    job->end = now_ms();
+    job->done = true;
+    for (Job* d : job->dependents)
+        if (--d->waiting == 0) make_ready(d);
+    unfinished--;
+    if (unfinished == 0) progress.notify_all();
+}
+
+void JobSystem::run_loop(Loop& loop) {
+    for (size_t c = loop.next++; c < loop.chunks; c = loop.next++) {
+        size_t b = loop.begin + c * loop.grain;
+        (*loop.fn)(b, std::min(loop.end, b + loop.grain));
+        loop.finished++;
+    }
+}
+
+void JobSystem::worker_main(int index) {
+    current_pool = this;
+    current_index = index;
+    for (;;) {
+        Task t;
+        if (pop(index, t) || steal(index, t)) {
+            run(t, index);
+            continue;
+        }
+        unique_lock<mutex> g(sleep_lock);
+        wake.wait(g, [this] { return stopping || queued > 0; });
+        if (stopping) return;
+    }
+}
+
+void JobSystem::wait() {
+    unique_lock<mutex> g(lock);
+    while (unfinished > 0) {
+        progress.wait(g, [this] { return unfinished == 0 || !ready_main.empty(); });
+        while (!ready_main.empty()) {
+            Task t;
+            t.job = ready_main.front();
+            ready_main.pop_front();
+            g.unlock();
+            run(t, 0);
+            g.lock();
+        }
+    }
+}
+
+void JobSystem::parallel_for(const char* name, size_t begin, size_t end, size_t grain, const function<void(size_t, size_t)>& fn) {
+    if (end <= begin) return;
+    auto start = chrono::steady_clock::now();
+    shared_ptr<Loop> loop = make_shared<Loop>();
+    loop->fn = &fn;
+    loop->begin = begin;
+    loop->end = end;
+    loop->grain = std::max<size_t>(grain, 1);
+    loop->chunks = (end - begin + loop->grain - 1) / loop->grain;
+
+    // Помощник, взявший задачу после того, как куски кончились, сразу
+    // выходит; fn он не трогает, поэтому может пережить этот вызов.
+    size_t helpers = std::min(workers.size(), loop->chunks - 1);
+    for (size_t h = 0; h < helpers; h++) {
+        Task t;
+        t.loop = loop;
+        push(std::move(t));
+    }
+    // своя доля; внутри задачи её время уже учитывает run()
+    if (in_task) run_loop(*loop);
+    else {
+        auto own = chrono::steady_clock::now();
+        run_loop(*loop);
+        int thread = current_pool == this ? current_index : 0;
+        *busy_ns[thread] += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - own).count();
+    }
+    // остались куски, которые ещё выполняют другие потоки
+    while (loop->finished < loop->chunks) this_thread::yield();
+
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    lock_guard<mutex> g(stats_lock);
+    LoopStat& s = loop_stats[name];
+    s.calls++;
+    s.total += ms;
+    s.longest = std::max(s.longest, ms);
+}
+
+void JobSystem::timeline(ostream& out) {
+    lock_guard<mutex> g(lock);
+    vector<const Job*> order;
+    double total = 0.0, busy = 0.0;
+    for (const Job& j : jobs) {
+        if (!j.done) continue;
+        order.push_back(&j);
+        total = std::max(total, j.end);
+        busy += j.end - j.start;
+    }
+    std::sort(order.begin(), order.end(), [](const Job* a, const Job* b) { return a->start < b->start; });
+
+    char line[256];
+    for (const Job* j : order) {
+        snprintf(line, sizeof(line), "%8.2f ms +%7.2f ms  %-4s %s\n", j->start, j->end - j->start,
+            j->thread == 0 ? "main" : ("w" + to_string(j->thread)).c_str(), j->name.c_str());
+        out << line;
+    }
+    snprintf(line, sizeof(line), "%zu jobs, %.2f ms wall, %.2f ms of work (%.1fx parallel)\n",
+        order.size(), total, busy, total > 0.0 ? busy / total : 0.0);
+    out << line;
+    if (unfinished == 0) jobs.clear();
+}
+
+void JobSystem::forget() {
+    lock_guard<mutex> g(lock);
+    if (unfinished == 0) jobs.clear();
+}
+
+void JobSystem::stats(ostream& out) {
+    lock_guard<mutex> g(stats_lock);
+    auto now = chrono::steady_clock::now();
+    double wall = chrono::duration<double, milli>(now - stats_since).count();
+    stats_since = now;
+
+    char line[256];
+    for (auto& l : loop_stats) {
+        snprintf(line, sizeof(line), "%-20s %6d calls  %8.3f ms avg  %8.3f ms max\n", l.first.c_str(),
+            l.second.calls, l.second.total / l.second.calls, l.second.longest);
+        out << line;
+    }
+    loop_stats.clear();
+    out << "busy:";
+    for (size_t i = 0; i < busy_ns.size(); i++) {
+        double ms = busy_ns[i]->exchange(0) / 1e6;
+        snprintf(line, sizeof(line), " %s %.0f%%", i == 0 ? "main" : ("w" + to_string(i)).c_str(),
+            wall > 0.0 ? 100.0 * ms / wall : 0.0);
+        out << line;
+    }
+    snprintf(line, sizeof(line), " (%.0f ms)\n", wall);
+    out << line;
+}
+
+void JobSystem::shutdown() {
+    {
+        lock_guard<mutex> g(sleep_lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (thread& w : workers)
+        if (w.joinable()) w.join();
+    workers.clear();
+    for (auto& q : queues) {
+        lock_guard<mutex> g(q->lock);
+        q->tasks.clear();
+    }
+    queued = 0;
+}
@@ -0,0 +1,154 @@
+﻿#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+using namespace std;
+
+/// <summary>
+/// Пул рабочих потоков с кражей работы и графом зависимостей между
+/// задачами. У каждого потока своя очередь: новые задачи кладутся в
+/// очередь добавившего потока и берутся оттуда с конца (последняя
+/// добавленная, её данные ещё в кэше), а простаивающий поток крадёт с
+/// начала чужой очереди. Задача запускается, когда завершены все её
+/// зависимости. Задачи с main_thread выполняются только в потоке,
+/// вызвавшем wait() (там, где GL контекст). parallel_for делит диапазон
+/// на куски, которые разбирают все потоки вместе с вызвавшим.
+///
+/// Для каждой задачи запоминается поток и время выполнения (timeline()),
+/// для циклов parallel_for - число вызовов и время, для потоков - доля
+/// времени за работой (stats()).
+/// </summary>
+class JobSystem
+{
+public:
+    typedef int JobId;
+
+    /// <param name="threads">Число рабочих потоков; 0 - по числу ядер.</param>
+    explicit JobSystem(int threads = 0);
+    ~JobSystem();
+
+    /// <summary>
+    /// Добавление задачи. Можно вызывать и из выполняющейся задачи.
+    /// </summary>
+    /// <param name="name">Имя для отчёта.</param>
+    /// <param name="deps">Задачи, которые должны завершиться раньше.</param>
+    /// <param name="main_thread">Выполнить в потоке, вызывающем wait().</param>
+    JobId add(const string& name, function<void()> fn, const vector<JobId>& deps = {}, bool main_thread = false);
+
+    /// <summary>
+    /// Ожидание всех задач; пока ждёт, выполняет задачи главного потока.
+    /// </summary>
+    void wait();
+
+    /// <summary>
+    /// fn(b, e) для кусков [b, e) диапазона [begin, end) длиной не больше
+    /// grain. Вызывающий поток разбирает куски вместе с рабочими и
+    /// возвращается, когда выполнены все. Можно вызывать из задач.
+    /// </summary>
+    /// <param name="name">Имя для stats().</param>
+    void parallel_for(const char* name, size_t begin, size_t end, size_t grain, const function<void(size_t, size_t)>& fn);
+
+    /// <summary>
+    /// Отчёт о выполненных задачах: начало и длительность от первой задачи,
+    /// поток, имя. Список задач после этого очищается.
+    /// </summary>
+    void timeline(ostream& out);
+
+    /// <summary>
+    /// Очистка списка выполненных задач без отчёта (для задач, которые
+    /// добавляются каждый кадр). Вызывается после wait().
+    /// </summary>
+    void forget();
+
+    /// <summary>
+    /// Время циклов parallel_for (вызовов, среднее и наибольшее) и загрузка
+    /// потоков с прошлого вызова stats(); счётчики после этого сбрасываются.
+    /// </summary>
+    void stats(ostream& out);
+
+    int thread_count() const { return (int)workers.size(); }
+
+    /// <summary>
+    /// Остановка потоков (задачи, не успевшие начаться, отбрасываются).
+    /// </summary>
+    void shutdown();
+private:
+    struct Job {
+        string name;
+        function<void()> fn;
+        vector<Job*> dependents;
+        int waiting = 0;
+        bool main_thread = false;
+        bool done = false;
+        int thread = -1;     // 0 - главный поток, 1.. - рабочие
+        double start = 0.0;  // мс от epoch
+        double end = 0.0;
+    };
+
+    // общее состояние parallel_for: куски раздаются счётчиком next
+    struct Loop {
+        const function<void(size_t, size_t)>* fn;
+        size_t begin, end, grain, chunks;
+        atomic<size_t> next{ 0 };
+        atomic<size_t> finished{ 0 };
+    };
+
+    // элемент очереди потока: задача графа или помощь циклу
+    struct Task {
+        Job* job = nullptr;
+        shared_ptr<Loop> loop;
+    };
+
+    struct WorkQueue {
+        mutex lock;
+        deque<Task> tasks;
+    };
+
+    struct LoopStat {
+        int calls = 0;
+        double total = 0.0, longest = 0.0;  // мс
+    };
+
+    void worker_main(int index);
+    void push(Task t);
+    bool pop(int thread, Task& t);
+    bool steal(int thread, Task& t);
+    void run(const Task& t, int thread);
+    void run_job(Job* job, int thread);
+    void run_loop(Loop& loop);
+    void finish(Job* job);
+    void make_ready(Job* job);
+    double now_ms() const;
+
+    vector<thread> workers;
+    // очередь 0 - потоков вне пула (главного), 1.. - рабочих
+    vector<unique_ptr<WorkQueue>> queues;
+    vector<unique_ptr<atomic<int64_t>>> busy_ns;   // время за работой по потокам
+
+    mutex lock;                   // граф задач
+    condition_variable progress;  // задача для главного потока или завершение
+    deque<Job> jobs;              // deque не перемещает элементы при push_back
+    deque<Job*> ready_main;
+    int unfinished = 0;
+    chrono::steady_clock::time_point epoch;
+
+    mutex sleep_lock;
+    condition_variable wake;      // в очередях появилась работа
+    atomic<int> queued{ 0 };
+    atomic<bool> stopping{ false };
+
+    mutex stats_lock;
+    map<string, LoopStat> loop_stats;
+    chrono::steady_clock::time_point stats_since;
+};
@@ -0,0 +1,129 @@
+﻿// Lz4.cpp
+#include "Lz4.h"
+#include <cstdint>
+#include <cstring>
+
+namespace {
+    const size_t MIN_MATCH = 4;
+    const size_t LAST_LITERALS = 5;   // последние байты блока всегда литералы
+    const size_t MATCH_LIMIT = 12;    // совпадение не начинается ближе к концу
+    const size_t MAX_OFFSET = 65535;
+    const int HASH_BITS = 16;
+
+    uint32_t read32(const unsigned char* p) {
+        uint32_t v;
+        memcpy(&v, p, 4);
+        return v;
+    }
+
+    uint32_t hash4(uint32_t v) {
+        return (v * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    void put_length(vector<unsigned char>& out, size_t len) {
+        while (len >= 255) {
+            out.push_back(255);
+            len -= 255;
+        }
+        out.push_back((unsigned char)len);
+    }
+
+    void emit(vector<unsigned char>& out, const unsigned char* lit, size_t lit_len, size_t offset, size_t match_len) {
+        size_t ml = match_len ? match_len - MIN_MATCH : 0;
+        unsigned char token = (unsigned char)((lit_len < 15 ? lit_len : 15) << 4 | (ml < 15 ? ml : 15));
+        out.push_back(token);
+        if (lit_len >= 15) put_length(out, lit_len - 15);
+        out.insert(out.end(), lit, lit + lit_len);
+        if (!match_len) return;
+        out.push_back((unsigned char)(offset & 0xFF));
+        out.push_back((unsigned char)(offset >> 8));
+        if (ml >= 15) put_length(out, ml - 15);
+    }
+}
+
+vector<unsigned char> Lz4Compress(const unsigned char* src, size_t size) {
+    vector<unsigned char> out;
+    out.reserve(size + size / 255 + 16);
+    vector<int64_t> table((size_t)1 << HASH_BITS, -1);
+
+    size_t anchor = 0;
+    size_t i = 0;
+    if (size > MATCH_LIMIT) {
+        size_t match_end_limit = size - LAST_LITERALS;
+        while (i + MATCH_LIMIT <= size) {
+            uint32_t seq = read32(src + i);
+            uint32_t h = hash4(seq);
+            int64_t cand = table[h];
+            table[h] = (int64_t)i;
+            if (cand < 0 || i - (size_t)cand > MAX_OFFSET || read32(src + cand) != seq) {
+                i++;
+                continue;
+            }
+
+            // продлеваем совпадение назад по литералам и вперёд до лимита
+            size_t start = i, ref = (size_t)cand;
+            while (start > anchor && ref > 0 && src[start - 1] == src[ref - 1]) {
+                start--;
+                ref--;
+            }
+            size_t len = i - start + MIN_MATCH;
+            while (start + len < match_end_limit && src[ref + len] == src[start + len]) len++;
+
+            emit(out, src + anchor, start - anchor, start - ref, len);
+            i = start + len;
+            anchor = i;
+            if (i >= 2 && i + MATCH_LIMIT <= size) table[hash4(read32(src + i - 2))] = (int64_t)(i - 2);
+        }
+    }
+    emit(out, src + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+bool Lz4Decompress(const unsigned char* src, size_t size, unsigned char* dst, size_t dst_size) {
+    const unsigned char* ip = src;
+    const unsigned char* iend = src + size;
+    size_t op = 0;
+
+    while (ip < iend) {
+        unsigned token = *ip++;
+
+        size_t lit_len = token >> 4;
+        if (lit_len == 15) {
+            unsigned char b;
+            do {
+                if (ip >= iend) return false;
+                b = *ip++;
+                lit_len += b;
+            } while (b == 255);
+        }
+        if (lit_len > (size_t)(iend - ip) || lit_len > dst_size - op) return false;
+        memcpy(dst + op, ip, lit_len);
+        ip += lit_len;
+        op += lit_len;
+        if (ip == iend) break; // последняя последовательность - только литералы
+
+        if (iend - ip < 2) return false;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op) return false;
+
+        size_t match_len = token & 15;
+        if (match_len == 15) {
+            unsigned char b;
+            do {
+                if (ip >= iend) return false;
+                b = *ip++;
+                match_len += b;
+            } while (b == 255);
+        }
+        match_len += MIN_MATCH;
+        if (match_len > dst_size - op) return false;
+
+        // копия побайтно: источник может перекрываться с приёмником
+        unsigned char* d = dst + op;
+        const unsigned char* s = d - offset;
+        for (size_t k = 0; k < match_len; k++) d[k] = s[k];
+        op += match_len;
+    }
+    return op == dst_size;
+}
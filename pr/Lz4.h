@@ -0,0 +1,20 @@
+﻿#pragma once
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// Блочный формат LZ4 (без кадра): последовательности "токен, литералы,
+// смещение, длина совпадения". Декодер совместим с любым кодером LZ4,
+// кодер - простой жадный с хэш-таблицей, для офлайн упаковки.
+
+/// <summary>
+/// Сжатие блока. Результат может оказаться больше исходных данных.
+/// </summary>
+vector<unsigned char> Lz4Compress(const unsigned char* src, size_t size);
+
+/// <summary>
+/// Распаковка блока ровно в dst_size байт.
+/// </summary>
+/// <returns>false, если данные повреждены или размер не совпал.</returns>
+bool Lz4Decompress(const unsigned char* src, size_t size, unsigned char* dst, size_t dst_size);
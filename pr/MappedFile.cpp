@@ -0,0 +1,103 @@
+﻿// MappedFile.cpp
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // пустой файл отобразить нельзя, но он должен открываться
+    const unsigned char empty_file[1] = { 0 };
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const char* path) {
+    close();
+    HANDLE f = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (f == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(f, &size)) {
+        CloseHandle(f);
+        return false;
+    }
+    if (size.QuadPart == 0) {
+        CloseHandle(f);
+        view = empty_file;
+        length = 0;
+        return true;
+    }
+
+    HANDLE m = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m) {
+        CloseHandle(f);
+        return false;
+    }
+    void* p = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+    if (!p) {
+        CloseHandle(m);
+        CloseHandle(f);
+        return false;
+    }
+    file = f;
+    mapping = m;
+    view = (const unsigned char*)p;
+    length = (size_t)size.QuadPart;
+    return true;
+}
+
+void MappedFile::close() {
+    if (view && view != empty_file) UnmapViewOfFile(view);
+    if (mapping) CloseHandle((HANDLE)mapping);
+    if (file) CloseHandle((HANDLE)file);
+    view = nullptr;
+    mapping = nullptr;
+    file = nullptr;
+    length = 0;
+}
+
+#else
+
+bool MappedFile::open(const char* path) {
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+    if (st.st_size == 0) {
+        ::close(fd);
+        view = empty_file;
+        length = 0;
+        return true;
+    }
+    void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // отображение живёт и без дескриптора
+    if (p == MAP_FAILED) return false;
+    view = (const unsigned char*)p;
+    length = (size_t)st.st_size;
+    return true;
+}
+
+void MappedFile::close() {
+    if (view && view != empty_file) munmap((void*)view, length);
+    view = nullptr;
+    length = 0;
+}
+
+#endif
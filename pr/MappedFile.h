@@ -0,0 +1,33 @@
+﻿#pragma once
+#include <cstddef>
+
+/// <summary>
+/// Файл, отображённый в память только для чтения. Страницы подгружаются
+/// системой при первом обращении, копирования в буфер нет.
+/// </summary>
+class MappedFile
+{
+public:
+    MappedFile() {}
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /// <summary>
+    /// Отображение файла целиком.
+    /// </summary>
+    /// <returns>false, если файл не открылся или не отобразился.</returns>
+    bool open(const char* path);
+    void close();
+
+    const unsigned char* data() const { return view; }
+    size_t size() const { return length; }
+    bool is_open() const { return view != nullptr; }
+private:
+    const unsigned char* view = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#endif
+};
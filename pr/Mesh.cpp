@@ -0,0 +1,199 @@
+﻿// Mesh.cpp
+#include "Mesh.h"
+#include <algorithm>
+
+SimpleMesh make_box(glm::vec3 center, glm::vec3 size, glm::vec3 color) {
+    glm::vec3 hs = size * 0.5f;
+    glm::vec3 v[8] = {
+        center + glm::vec3(-hs.x, -hs.y, -hs.z),
+        center + glm::vec3(hs.x, -hs.y, -hs.z),
+        center + glm::vec3(hs.x,  hs.y, -hs.z),
+        center + glm::vec3(-hs.x,  hs.y, -hs.z),
+
+        center + glm::vec3(-hs.x, -hs.y,  hs.z),
+        center + glm::vec3(hs.x, -hs.y,  hs.z),
+        center + glm::vec3(hs.x,  hs.y,  hs.z),
+        center + glm::vec3(-hs.x,  hs.y,  hs.z)
+    };
+    GLuint faceIndices[] = {
+        0,1,2, 0,2,3,
+        4,5,6, 4,6,7,
+        8,9,10, 8,10,11,
+    };
+    SimpleMesh m;
+    for (int i = 0; i < 8; i++) m.verts.push_back(v[i]);
+    for (int i = 0; i < 8; i++) m.cols.push_back(color);
+
+    GLuint idxs[] = {
+        0,1,2, 0,2,3,
+        4,5,6, 4,6,7,
+        0,4,7, 0,7,3,
+        1,5,6, 1,6,2,
+        3,2,6, 3,6,7,
+        0,1,5, 0,5,4
+    };
+    for (auto v : idxs) m.inds.push_back(v);
+    return m;
+}
+
+SimpleMesh make_textured_box(glm::vec3 center, glm::vec3 size) {
+    glm::vec3 hs = size * 0.5f;
+    glm::vec3 v[8] = {
+        center + glm::vec3(-hs.x, -hs.y, -hs.z), // 0
+        center + glm::vec3(hs.x, -hs.y, -hs.z),  // 1
+        center + glm::vec3(hs.x,  hs.y, -hs.z),  // 2
+        center + glm::vec3(-hs.x,  hs.y, -hs.z), // 3
+        center + glm::vec3(-hs.x, -hs.y,  hs.z), // 4
+        center + glm::vec3(hs.x, -hs.y,  hs.z),  // 5
+        center + glm::vec3(hs.x,  hs.y,  hs.z),  // 6
+        center + glm::vec3(-hs.x,  hs.y,  hs.z)  // 7
+    };
+
+    SimpleMesh m;
+
+    int faceVerts[6][4] = {
+        {0,1,2,3}, // back
+        {4,5,6,7}, // front  
+        {0,4,7,3}, // left
+        {1,5,6,2}, // right
+        {3,2,6,7}, // top
+        {0,1,5,4}  // bottom
+    };
+
+    glm::vec2 faceUVs[4] = {
+        glm::vec2(0.0f, 0.0f),  // нижний левый
+        glm::vec2(1.0f, 0.0f),  // нижний правый  
+        glm::vec2(1.0f, 1.0f),  // верхний правый
+        glm::vec2(0.0f, 1.0f)   // верхний левый
+    };
+
+    for (int f = 0; f < 6; f++) {
+        int base = m.verts.size();
+
+        m.verts.push_back(v[faceVerts[f][0]]);
+        m.verts.push_back(v[faceVerts[f][1]]);
+        m.verts.push_back(v[faceVerts[f][2]]);
+        m.verts.push_back(v[faceVerts[f][3]]);
+
+        m.uvs.push_back(faceUVs[0]);
+        m.uvs.push_back(faceUVs[1]);
+        m.uvs.push_back(faceUVs[2]);
+        m.uvs.push_back(faceUVs[3]);
+
+        for (int i = 0; i < 4; i++)
+            m.cols.push_back(glm::vec3(1.0f));
+
+        m.inds.push_back(base + 0);
+        m.inds.push_back(base + 1);
+        m.inds.push_back(base + 2);
+
+        m.inds.push_back(base + 0);
+        m.inds.push_back(base + 2);
+        m.inds.push_back(base + 3);
+    }
+
+    return m;
+}
+
+SimpleMesh make_cable(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, int segments, glm::vec3 color) {
+    SimpleMesh m;
+    for (int i = 0; i <= segments; i++) {
+        float t = (float)i / segments;
+        glm::vec3 p = (1 - t) * (1 - t) * p0 + 2 * (1 - t) * t * p1 + t * t * p2;
+        glm::vec3 tangent = glm::normalize(2 * (1 - t) * (p1 - p0) + 2 * t * (p2 - p1));
+        glm::vec3 up = glm::vec3(0, 1, 0);
+        glm::vec3 bit = glm::normalize(glm::cross(tangent, up));
+        float width = 0.015f;
+        glm::vec3 a = p - bit * width;
+        glm::vec3 b = p + bit * width;
+        m.verts.push_back(a);
+        m.verts.push_back(b);
+        m.cols.push_back(color);
+        m.cols.push_back(color);
+        if (i > 0) {
+            GLuint base = (GLuint)m.verts.size() - 4;
+            m.inds.push_back(base + 0);
+            m.inds.push_back(base + 1);
+            m.inds.push_back(base + 2);
+
+            m.inds.push_back(base + 1);
+            m.inds.push_back(base + 3);
+            m.inds.push_back(base + 2);
+        }
+    }
+    return m;
+}
+
+SimpleMesh make_cable_patches(const std::vector<glm::vec3>& points, glm::vec3 color) {
+    SimpleMesh m;
+    m.verts = points;
+    m.cols.assign(points.size(), color);
+    int last = (int)points.size() - 1;
+    for (int i = 0; i < last; i++) {
+        m.inds.push_back((GLuint)std::max(i - 1, 0));
+        m.inds.push_back((GLuint)i);
+        m.inds.push_back((GLuint)(i + 1));
+        m.inds.push_back((GLuint)std::min(i + 2, last));
+    }
+    return m;
+}
+
+SimpleMesh make_colored_room() {
+    SimpleMesh m;
+
+    glm::vec3 center(0.0f);
+    glm::vec3 size(6.0f, 4.0f, 6.0f);
+    glm::vec3 hs = size * 0.5f;
+
+    glm::vec3 v[8] = {
+        center + glm::vec3(-hs.x, -hs.y, -hs.z), // 0
+        center + glm::vec3(hs.x, -hs.y, -hs.z),  // 1
+        center + glm::vec3(hs.x,  hs.y, -hs.z),  // 2
+        center + glm::vec3(-hs.x,  hs.y, -hs.z), // 3
+
+        center + glm::vec3(-hs.x, -hs.y,  hs.z), // 4
+        center + glm::vec3(hs.x, -hs.y,  hs.z),  // 5
+        center + glm::vec3(hs.x,  hs.y,  hs.z),  // 6
+        center + glm::vec3(-hs.x,  hs.y,  hs.z)  // 7
+    };
+
+    int faceVerts[6][4] = {
+        {0,1,2,3},
+        {4,5,6,7},
+        {0,4,7,3},
+        {1,5,6,2},
+        {3,2,6,7},
+        {0,1,5,4} 
+    };
+
+    glm::vec3 colors[6] = {
+        glm::vec3(0.94f, 0.90f, 0.75f),  
+        glm::vec3(0.94f, 0.90f, 0.75f),  
+        glm::vec3(0.94f, 0.90f, 0.82f),  
+        glm::vec3(0.94f, 0.90f, 0.82f),  
+        glm::vec3(1.0f, 0.97f, 0.70f),
+        glm::vec3(0.45f, 0.30f, 0.18f) 
+    };
+
+    for (int f = 0; f < 6; f++) {
+        int base = m.verts.size();
+
+        m.verts.push_back(v[faceVerts[f][0]]);
+        m.verts.push_back(v[faceVerts[f][1]]);
+        m.verts.push_back(v[faceVerts[f][2]]);
+        m.verts.push_back(v[faceVerts[f][3]]);
+
+        for (int i = 0; i < 4; i++)
+            m.cols.push_back(colors[f]);
+
+        m.inds.push_back(base + 0);
+        m.inds.push_back(base + 1);
+        m.inds.push_back(base + 2);
+
+        m.inds.push_back(base + 0);
+        m.inds.push_back(base + 2);
+        m.inds.push_back(base + 3);
+    }
+
+    return m;
+}
@@ -0,0 +1,42 @@
+﻿#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+/// <summary>
+/// Геометрия на стороне CPU: вершины, цвета, uv и индексы треугольников.
+/// Пустые массивы цветов или uv означают, что атрибута нет.
+/// </summary>
+struct SimpleMesh {
+    std::vector<glm::vec3> verts;
+    std::vector<glm::vec3> cols;
+    std::vector<glm::vec2> uvs;
+    std::vector<GLuint> inds;
+};
+
+/// <summary>
+/// Параллелепипед одного цвета (8 вершин, без uv).
+/// </summary>
+SimpleMesh make_box(glm::vec3 center, glm::vec3 size, glm::vec3 color);
+
+/// <summary>
+/// Параллелепипед с отдельными вершинами и uv на каждой грани.
+/// </summary>
+SimpleMesh make_textured_box(glm::vec3 center, glm::vec3 size);
+
+/// <summary>
+/// Плоская лента вдоль квадратичной кривой Безье p0-p1-p2.
+/// </summary>
+SimpleMesh make_cable(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, int segments, glm::vec3 color);
+
+/// <summary>
+/// Опорные точки кабеля для тесселяции на GPU: вершины - сами точки,
+/// индексы - патчи по 4 соседние точки (концы повторяются), по одному на
+/// отрезок.
+/// </summary>
+SimpleMesh make_cable_patches(const std::vector<glm::vec3>& points, glm::vec3 color);
+
+/// <summary>
+/// Комната 6x4x6 с разным цветом стен, пола и потолка.
+/// </summary>
+SimpleMesh make_colored_room();
@@ -0,0 +1,111 @@
+﻿// MeshFile.cpp
+#include "MeshFile.h"
+#include <cstring>
+#include <algorithm>
+
+namespace {
+    uint32_t align_up(uint32_t v) {
+        return (v + MESH_ALIGN - 1) & ~(MESH_ALIGN - 1);
+    }
+
+    void put(vector<unsigned char>& out, size_t offset, const void* src, size_t size) {
+        memcpy(out.data() + offset, src, size);
+    }
+}
+
+bool ParseMeshFile(const unsigned char* data, size_t size, MeshView& out) {
+    if (size < sizeof(MeshFileHeader)) return false;
+    MeshFileHeader h;
+    memcpy(&h, data, sizeof(h));
+    if (h.magic != MESH_MAGIC || h.version != MESH_VERSION) return false;
+    if (h.attrib_count == 0 || h.stride == 0) return false;
+
+    size_t attribs_end = sizeof(MeshFileHeader) + (size_t)h.attrib_count * sizeof(MeshAttrib);
+    if (attribs_end > size) return false;
+    if ((uint64_t)h.vertex_offset + h.vertex_size > size) return false;
+    if ((uint64_t)h.index_offset + h.index_size > size) return false;
+    if ((uint64_t)h.vertex_count * h.stride != h.vertex_size) return false;
+    if ((uint64_t)h.index_count * sizeof(uint32_t) != h.index_size) return false;
+    if (h.vertex_offset % MESH_ALIGN || h.index_offset % MESH_ALIGN) return false;
+
+    const MeshAttrib* attribs = (const MeshAttrib*)(data + sizeof(MeshFileHeader));
+    for (uint32_t i = 0; i < h.attrib_count; i++) {
+        const MeshAttrib& a = attribs[i];
+        // vs.glsl объявляет только location 0-2, и только float
+        if (a.location > 2 || a.components < 1 || a.components > 4 || a.type != GL_FLOAT) return false;
+        if ((uint64_t)a.offset + a.components * 4 > h.stride) return false;
+    }
+    // индексы за пределами вершин - чтение мимо буфера и в PickMesh, и в GL
+    const uint32_t* indices = (const uint32_t*)(data + h.index_offset);
+    for (uint32_t i = 0; i < h.index_count; i++)
+        if (indices[i] >= h.vertex_count) return false;
+
+    out.header = h;
+    out.attribs = attribs;
+    out.vertices = data + h.vertex_offset;
+    out.indices = indices;
+    return true;
+}
+
+bool OpenMeshFile(const char* name, MeshView& out) {
+    AssetBlob blob = LoadAsset(name);
+    if (!blob || !ParseMeshFile(blob.data, blob.size, out)) return false;
+    out.blob = blob;
+    return true;
+}
+
+vector<unsigned char> BakeMeshFile(const SimpleMesh& mesh) {
+    bool has_colors = mesh.cols.size() == mesh.verts.size() && !mesh.cols.empty();
+    bool has_uvs = mesh.uvs.size() == mesh.verts.size() && !mesh.uvs.empty();
+
+    // раскладка совпадает с location в vs.glsl: 0 - позиция, 1 - цвет, 2 - uv
+    vector<MeshAttrib> attribs;
+    uint32_t stride = 0;
+    attribs.push_back({ 0, 3, GL_FLOAT, stride });
+    stride += 12;
+    if (has_colors) {
+        attribs.push_back({ 1, 3, GL_FLOAT, stride });
+        stride += 12;
+    }
+    if (has_uvs) {
+        attribs.push_back({ 2, 2, GL_FLOAT, stride });
+        stride += 8;
+    }
+
+    MeshFileHeader h = {};
+    h.magic = MESH_MAGIC;
+    h.version = MESH_VERSION;
+    h.vertex_count = (uint32_t)mesh.verts.size();
+    h.index_count = (uint32_t)mesh.inds.size();
+    h.attrib_count = (uint32_t)attribs.size();
+    h.stride = stride;
+    h.vertex_offset = align_up((uint32_t)(sizeof(MeshFileHeader) + attribs.size() * sizeof(MeshAttrib)));
+    h.vertex_size = h.vertex_count * stride;
+    h.index_offset = align_up(h.vertex_offset + h.vertex_size);
+    h.index_size = h.index_count * (uint32_t)sizeof(uint32_t);
+
+    for (int c = 0; c < 3; c++) {
+        h.bounds_min[c] = mesh.verts.empty() ? 0.0f : mesh.verts[0][c];
+        h.bounds_max[c] = h.bounds_min[c];
+    }
+    for (const glm::vec3& v : mesh.verts) {
+        for (int c = 0; c < 3; c++) {
+            h.bounds_min[c] = std::min(h.bounds_min[c], v[c]);
+            h.bounds_max[c] = std::max(h.bounds_max[c], v[c]);
+        }
+    }
+
+    vector<unsigned char> out(align_up(h.index_offset + h.index_size), 0);
+    put(out, 0, &h, sizeof(h));
+    put(out, sizeof(h), attribs.data(), attribs.size() * sizeof(MeshAttrib));
+
+    size_t at = h.vertex_offset;
+    for (size_t i = 0; i < mesh.verts.size(); i++) {
+        put(out, at, &mesh.verts[i], 12);
+        if (has_colors) put(out, at + attribs[1].offset, &mesh.cols[i], 12);
+        if (has_uvs) put(out, at + attribs.back().offset, &mesh.uvs[i], 8);
+        at += stride;
+    }
+    if (h.index_size) put(out, h.index_offset, mesh.inds.data(), h.index_size);
+    return out;
+}
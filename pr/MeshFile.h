@@ -0,0 +1,76 @@
+﻿#pragma once
+#include "Mesh.h"
+#include "Assets.h"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Формат .mesh - сетка, готовая к загрузке в GPU без разбора:
+//   MeshFileHeader
+//   MeshAttrib[attrib_count]  - раскладка вершины
+//   вершины (чередующиеся атрибуты, stride байт на вершину)
+//   индексы (uint32)
+// Оба блока выровнены на MESH_ALIGN байт от начала файла, поэтому файл
+// можно отобразить в память и передать указатели прямо в glBufferData.
+
+const uint32_t MESH_MAGIC = 0x4853454D; // "MESH"
+const uint32_t MESH_VERSION = 1;
+const uint32_t MESH_ALIGN = 16;
+
+struct MeshFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertex_count;
+    uint32_t index_count;
+    uint32_t attrib_count;
+    uint32_t stride;
+    uint32_t vertex_offset;
+    uint32_t vertex_size;
+    uint32_t index_offset;
+    uint32_t index_size;
+    float bounds_min[3];
+    float bounds_max[3];
+};
+
+/// <summary>
+/// Атрибут вершины: location в шейдере, число компонент, тип GL и
+/// смещение внутри вершины.
+/// </summary>
+struct MeshAttrib {
+    uint32_t location;
+    uint32_t components;
+    uint32_t type;
+    uint32_t offset;
+};
+
+/// <summary>
+/// Разобранный .mesh. Указатели ведут в данные файла, blob удерживает их.
+/// </summary>
+struct MeshView {
+    MeshFileHeader header = {};
+    const MeshAttrib* attribs = nullptr;
+    const unsigned char* vertices = nullptr;
+    const uint32_t* indices = nullptr;
+    AssetBlob blob;
+};
+
+/// <summary>
+/// Разбор .mesh без копирования.
+/// </summary>
+/// <returns>false, если файл повреждён или неизвестной версии.</returns>
+bool ParseMeshFile(const unsigned char* data, size_t size, MeshView& out);
+
+/// <summary>
+/// Открытие .mesh через LoadAsset: файл с диска отображается в память,
+/// встроенный ресурс используется на месте.
+/// </summary>
+bool OpenMeshFile(const char* name, MeshView& out);
+
+/// <summary>
+/// Упаковка сетки в .mesh. Цвета и uv попадают в раскладку, только если
+/// они есть в сетке.
+/// </summary>
+vector<unsigned char> BakeMeshFile(const SimpleMesh& mesh);
@@ -0,0 +1,227 @@
+﻿// MeshImporter.cpp
+#include "MeshImporter.h"
+#include "AssetIOSystem.h"
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <assimp/ProgressHandler.hpp>
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    // Assimp вызывает Update между этапами загрузки; false прерывает
+    // ReadFile. Importer удаляет обработчик сам.
+    class ProgressReporter : public Assimp::ProgressHandler
+    {
+    public:
+        explicit ProgressReporter(ImportProgress* progress) : progress(progress) {}
+
+        bool Update(float percentage) override {
+            if (percentage >= 0.0f) progress->reported = percentage * 0.01f;
+            progress->steps++;
+            return !progress->cancelled();
+        }
+    private:
+        ImportProgress* progress;
+    };
+
+    // Первая диффузная текстура среди материалов сцены; путь в файле
+    // задан относительно модели.
+    string find_diffuse_texture(const aiScene* scene, const string& model_path) {
+        for (unsigned i = 0; i < scene->mNumMaterials; i++) {
+            aiString file;
+            if (aiGetMaterialTexture(scene->mMaterials[i], aiTextureType_DIFFUSE, 0, &file) != AI_SUCCESS)
+                continue;
+            if (file.length == 0 || file.data[0] == '*') continue; // встроенные текстуры не поддерживаются
+            size_t slash = model_path.find_last_of("/\\");
+            string dir = slash == string::npos ? "" : model_path.substr(0, slash + 1);
+            return dir + file.data;
+        }
+        return "";
+    }
+
+    // Обход дерева узлов с накоплением преобразований: каждая сетка узла
+    // дописывается в out уже в координатах сцены.
+    void append_node(const aiScene* scene, const aiNode* node, const aiMatrix4x4& parent, SimpleMesh& out) {
+        aiMatrix4x4 transform = parent * node->mTransformation;
+
+        for (unsigned m = 0; m < node->mNumMeshes; m++) {
+            const aiMesh* mesh = scene->mMeshes[node->mMeshes[m]];
+            if (!(mesh->mPrimitiveTypes & aiPrimitiveType_TRIANGLE)) continue;
+
+            aiColor4D diffuse(1.0f, 1.0f, 1.0f, 1.0f);
+            if (mesh->mMaterialIndex < scene->mNumMaterials)
+                aiGetMaterialColor(scene->mMaterials[mesh->mMaterialIndex], AI_MATKEY_COLOR_DIFFUSE, &diffuse);
+
+            GLuint base = (GLuint)out.verts.size();
+            for (unsigned v = 0; v < mesh->mNumVertices; v++) {
+                aiVector3D p = transform * mesh->mVertices[v];
+                out.verts.push_back(glm::vec3(p.x, p.y, p.z));
+                if (mesh->HasVertexColors(0)) {
+                    const aiColor4D& c = mesh->mColors[0][v];
+                    out.cols.push_back(glm::vec3(c.r, c.g, c.b));
+                }
+                else {
+                    out.cols.push_back(glm::vec3(diffuse.r, diffuse.g, diffuse.b));
+                }
+                if (mesh->HasTextureCoords(0)) {
+                    const aiVector3D& t = mesh->mTextureCoords[0][v];
+                    out.uvs.push_back(glm::vec2(t.x, t.y));
+                }
+                else {
+                    out.uvs.push_back(glm::vec2(0.0f));
+                }
+            }
+            for (unsigned f = 0; f < mesh->mNumFaces; f++) {
+                const aiFace& face = mesh->mFaces[f];
+                if (face.mNumIndices != 3) continue;
+                out.inds.push_back(base + face.mIndices[0]);
+                out.inds.push_back(base + face.mIndices[1]);
+                out.inds.push_back(base + face.mIndices[2]);
+            }
+        }
+        for (unsigned c = 0; c < node->mNumChildren; c++)
+            append_node(scene, node->mChildren[c], transform, out);
+    }
+}
+
+MeshImporter::MeshImporter(int threads) {
+    if (threads <= 0) threads = std::max(1, std::min(4, (int)thread::hardware_concurrency() - 1));
+    for (int i = 0; i < threads; i++)
+        workers.push_back(thread(&MeshImporter::worker_main, this));
+}
+
+MeshImporter::~MeshImporter() {
+    shutdown();
+}
+
+float ImportProgress::fraction() const {
+    if (finished) return 1.0f;
+    float r = reported;
+    if (r >= 0.0f) return r;
+    // чтение файла - основная часть работы, шаги обработки - остаток
+    size_t t = io.total;
+    float read = t ? (float)io.read / (float)t : 0.0f;
+    float post = 1.0f - 1.0f / (1.0f + steps);
+    return std::min(0.8f * read + 0.2f * post, 0.99f);
+}
+
+ImportResult MeshImporter::load(const string& path, ImportProgress* progress) {
+    ImportResult result;
+    result.path = path;
+
+    // файлы модели, включая MTL и текстуры, читаются через LoadAsset
+    Assimp::Importer importer;
+    importer.SetIOHandler(new AssetIOSystem(progress ? &progress->io : nullptr));
+    if (progress) importer.SetProgressHandler(new ProgressReporter(progress));
+    const aiScene* scene = importer.ReadFile(path,
+        aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_SortByPType |
+        aiProcess_ImproveCacheLocality | aiProcess_RemoveRedundantMaterials);
+    if (progress && progress->cancelled()) {
+        result.error = "cancelled";
+        return result;
+    }
+    if (!scene || !scene->mRootNode) {
+        result.error = importer.GetErrorString();
+        return result;
+    }
+
+    append_node(scene, scene->mRootNode, aiMatrix4x4(), result.mesh);
+    result.texture = find_diffuse_texture(scene, path);
+    result.ok = !result.mesh.inds.empty();
+    if (!result.ok) result.error = "no triangles";
+    return result;
+}
+
+shared_ptr<ImportProgress> MeshImporter::import(const char* path, Callback on_done) {
+    Job job;
+    job.result.path = path;
+    job.on_done = on_done;
+    job.progress = make_shared<ImportProgress>();
+    job.progress->path = path;
+    shared_ptr<ImportProgress> progress = job.progress;
+    pending++;
+    {
+        lock_guard<mutex> g(lock);
+        active.push_back(progress);
+        queue.push_back(std::move(job));
+    }
+    wake.notify_one();
+    return progress;
+}
+
+void MeshImporter::cancel_all() {
+    lock_guard<mutex> g(lock);
+    for (auto& p : active) p->cancel();
+}
+
+float MeshImporter::progress(int* count) {
+    lock_guard<mutex> g(lock);
+    if (count) *count = (int)active.size();
+    if (active.empty()) return 1.0f;
+    float sum = 0.0f;
+    for (auto& p : active) sum += p->fraction();
+    return sum / active.size();
+}
+
+void MeshImporter::worker_main() {
+    for (;;) {
+        Job job;
+        {
+            unique_lock<mutex> g(lock);
+            wake.wait(g, [this] { return stopping || !queue.empty(); });
+            if (stopping) return;
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        // отменённый до начала импорт даже не открывает файл
+        if (job.progress->cancelled()) job.result.error = "cancelled";
+        else job.result = load(job.result.path, job.progress.get());
+        job.progress->finished = true;
+
+        lock_guard<mutex> g(lock);
+        done.push_back(std::move(job));
+    }
+}
+
+void MeshImporter::poll(int max_results) {
+    for (int i = 0; i < max_results; i++) {
+        Job job;
+        {
+            lock_guard<mutex> g(lock);
+            if (done.empty()) return;
+            job = std::move(done.front());
+            done.pop_front();
+            active.erase(std::remove(active.begin(), active.end(), job.progress), active.end());
+        }
+        pending--;
+        if (job.progress->cancelled()) {
+            i--; // отменённые не занимают слот
+            continue;
+        }
+        if (!job.result.ok)
+            std::cerr << "Import of " << job.result.path << " failed: " << job.result.error << std::endl;
+        if (job.on_done) job.on_done(job.result);
+    }
+}
+
+bool MeshImporter::busy() {
+    return pending > 0;
+}
+
+void MeshImporter::shutdown() {
+    {
+        lock_guard<mutex> g(lock);
+        stopping = true;
+        for (auto& p : active) p->cancel();
+        queue.clear();
+        done.clear();
+        active.clear();
+    }
+    wake.notify_all();
+    for (thread& w : workers)
+        if (w.joinable()) w.join();
+    workers.clear();
+    pending = 0;
+}
@@ -0,0 +1,121 @@
+﻿#pragma once
+#include "Mesh.h"
+#include "AssetIOSystem.h"
+#include <string>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+using namespace std;
+
+/// <summary>
+/// Результат импорта файла модели: все сетки сцены, сведённые в одну, с
+/// применёнными преобразованиями узлов.
+/// </summary>
+struct ImportResult {
+    string path;
+    SimpleMesh mesh;
+    string texture; // диффузная текстура материала (имя ресурса), если есть
+    bool ok = false;
+    string error;
+};
+
+/// <summary>
+/// Состояние одного импорта, общее для рабочего потока и потока рендера.
+/// Прогресс оценивается по прочитанным байтам и вызовам ProgressHandler
+/// (Assimp 3.0 не сообщает процент сам).
+/// </summary>
+struct ImportProgress {
+    string path;
+    IOProgress io;
+    atomic<int> steps{ 0 };
+    atomic<float> reported{ -1.0f };
+    atomic<bool> finished{ false };
+
+    /// <summary>
+    /// Оценка готовности от 0 до 1.
+    /// </summary>
+    float fraction() const;
+    void cancel() { io.cancelled = true; }
+    bool cancelled() const { return io.cancelled; }
+};
+
+/// <summary>
+/// Загрузка моделей через Assimp в рабочих потоках (у каждого импорта свой
+/// Assimp::Importer, так что файлы разбираются параллельно). Разбор файла и
+/// перевод aiMesh в SimpleMesh идут в фоне, а обработчик завершения
+/// вызывается из poll() в потоке с GL контекстом, где можно грузить
+/// сетку в Model.
+/// </summary>
+class MeshImporter
+{
+public:
+    typedef function<void(ImportResult&)> Callback;
+
+    /// <param name="threads">Число рабочих потоков; 0 - по числу ядер.</param>
+    explicit MeshImporter(int threads = 0);
+    ~MeshImporter();
+
+    /// <summary>
+    /// Постановка файла в очередь импорта. Возвращается сразу.
+    /// </summary>
+    /// <param name="path">Путь к файлу модели.</param>
+    /// <param name="on_done">Вызывается из poll() после импорта (кроме отменённых).</param>
+    /// <returns>Прогресс импорта; через него же импорт можно отменить.</returns>
+    shared_ptr<ImportProgress> import(const char* path, Callback on_done);
+
+    /// <summary>
+    /// Отмена всех импортов: ждущие в очереди не начнутся, текущий
+    /// прервётся на ближайшем чтении или шаге обработки.
+    /// </summary>
+    void cancel_all();
+
+    /// <summary>
+    /// Средний прогресс незавершённых импортов и их число.
+    /// </summary>
+    float progress(int* count = nullptr);
+
+    /// <summary>
+    /// Вызов обработчиков готовых импортов. Не больше max_results за
+    /// вызов, чтобы загрузка сеток не растягивала кадр.
+    /// </summary>
+    void poll(int max_results = 1);
+
+    /// <summary>
+    /// Есть ли незавершённые импорты.
+    /// </summary>
+    bool busy();
+
+    /// <summary>
+    /// Остановка рабочих потоков; необработанные импорты отбрасываются.
+    /// </summary>
+    void shutdown();
+
+    /// <summary>
+    /// Синхронный импорт (используется рабочим потоком).
+    /// </summary>
+    /// <param name="progress">Куда сообщать о ходе импорта (может быть nullptr).</param>
+    static ImportResult load(const string& path, ImportProgress* progress = nullptr);
+private:
+    struct Job {
+        ImportResult result;
+        Callback on_done;
+        shared_ptr<ImportProgress> progress;
+    };
+
+    void worker_main();
+
+    vector<thread> workers;
+    mutex lock;
+    condition_variable wake;
+    deque<Job> queue;
+    deque<Job> done;
+    vector<shared_ptr<ImportProgress>> active;
+    bool stopping = false;
+    int pending = 0;
+};
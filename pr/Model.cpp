@@ -2,79 +2,50 @@
 #include "model.h"
 #include "func.h"
 
-GLuint compile_shader(const char* src, GLenum type) {
-    GLuint s = glCreateShader(type);
-    glShaderSource(s, 1, &src, nullptr);
-    glCompileShader(s);
-    GLint ok;
-    glGetShaderiv(s, GL_COMPILE_STATUS, &ok);
-    if (!ok) {
-        GLint len;
-        glGetShaderiv(s, GL_INFO_LOG_LENGTH, &len);
-        std::string log(len, ' ');
-        glGetShaderInfoLog(s, len, nullptr, &log[0]);
-        std::cerr << "Shader compile error: " << log << std::endl;
-    }
-    return s;
-}
-
-void Model::load_shaders(const char* vect, const char* frag) {
-    std::string vs_src = LoadShader(vect);
-    std::string fs_src = LoadShader(frag);
-    const char* vs_c = vs_src.c_str();
-    const char* fs_c = fs_src.c_str();
-
-    GLuint vs = compile_shader(vs_c, GL_VERTEX_SHADER);
-    GLuint fs = compile_shader(fs_c, GL_FRAGMENT_SHADER);
-
-    shader_programme = glCreateProgram();
-    glAttachShader(shader_programme, vs);
-    glAttachShader(shader_programme, fs);
-    glLinkProgram(shader_programme);
-
-    GLint ok;
-    glGetProgramiv(shader_programme, GL_LINK_STATUS, &ok);
-    if (!ok) {
-        GLint len;
-        glGetProgramiv(shader_programme, GL_INFO_LOG_LENGTH, &len);
-        std::string log(len, ' ');
-        glGetProgramInfoLog(shader_programme, len, nullptr, &log[0]);
-        std::cerr << "Program link error: " << log << std::endl;
-    }
-
-    glDeleteShader(vs);
-    glDeleteShader(fs);
+void Model::load_shaders(const char* vect, const char* frag, unsigned features) {
+    //     ,      
+    shader_programme = ShaderCache::instance().get(vect, frag, features);
 }
 
-void Model::load_coords(glm::vec3* verteces, size_t count) {
+void Model::load_coords(const glm::vec3* verteces, size_t count) {
     verteces_count = count;
+    layout.clear();
     glBindVertexArray(vao);
 
     if (vbo_coords == 0) glGenBuffers(1, &vbo_coords);
     glBindBuffer(GL_ARRAY_BUFFER, vbo_coords);
     glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::vec3), verteces, GL_STATIC_DRAW);
+    setup_attribs();
+}
 
-    // vertex attrib setup will be done in render (when program is used)
-    glBindVertexArray(0);
+void Model::stream_coords(const glm::vec3* verteces, size_t count) {
+    if (vbo_coords == 0 || !layout.empty() || count != verteces_count) {
+        load_coords(verteces, count);
+        return;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_coords);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::vec3), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(glm::vec3), verteces);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-void Model::load_uvs(glm::vec2* uvs, size_t count) {
+void Model::load_uvs(const glm::vec2* uvs, size_t count) {
     glBindVertexArray(vao);
     if (vbo_uvs == 0) glGenBuffers(1, &vbo_uvs);
     glBindBuffer(GL_ARRAY_BUFFER, vbo_uvs);
     glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::vec2), uvs, GL_STATIC_DRAW);
-    glBindVertexArray(0);
+    setup_attribs();
 }
 
-void Model::load_colors(glm::vec3* colors, size_t count) {
+void Model::load_colors(const glm::vec3* colors, size_t count) {
     glBindVertexArray(vao);
     if (vbo_colors == 0) glGenBuffers(1, &vbo_colors);
     glBindBuffer(GL_ARRAY_BUFFER, vbo_colors);
     glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::vec3), colors, GL_STATIC_DRAW);
-    glBindVertexArray(0);
+    setup_attribs();
 }
 
-void Model::load_indices(GLuint* indices, size_t count) {
+void Model::load_indices(const GLuint* indices, size_t count) {
     indices_count = count;
     glBindVertexArray(vao);
     if (ibo == 0) glGenBuffers(1, &ibo);
@@ -83,15 +54,48 @@ void Model::load_indices(GLuint* indices, size_t count) {
     glBindVertexArray(0);
 }
 
-void Model::render(GLuint mode) {
+void Model::load_mesh(const SimpleMesh& mesh) {
+    load_coords(mesh.verts.data(), mesh.verts.size());
+    if (!mesh.cols.empty()) load_colors(mesh.cols.data(), mesh.cols.size());
+    if (!mesh.uvs.empty()) load_uvs(mesh.uvs.data(), mesh.uvs.size());
+    load_indices(mesh.inds.data(), mesh.inds.size());
+}
+
+void Model::load_baked(const MeshView& mesh) {
+    const MeshFileHeader& h = mesh.header;
     glBindVertexArray(vao);
-    if (shader_programme) glUseProgram(shader_programme);  //     
+    if (vbo_coords == 0) glGenBuffers(1, &vbo_coords);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_coords);
+    glBufferData(GL_ARRAY_BUFFER, h.vertex_size, mesh.vertices, GL_STATIC_DRAW);
+
+    //      
+    if (vbo_colors) glDeleteBuffers(1, &vbo_colors);
+    if (vbo_uvs) glDeleteBuffers(1, &vbo_uvs);
+    vbo_colors = vbo_uvs = 0;
+
+    layout.assign(mesh.attribs, mesh.attribs + h.attrib_count);
+    stride = (GLsizei)h.stride;
+    setup_attribs();
+    verteces_count = h.vertex_count;
+    load_indices(mesh.indices, h.index_count);
+}
 
+//    vao.     vs.glsl
+// (layout(location)),      .
+void Model::setup_attribs() {
     GLint posLoc = 0;
     GLint colLoc = 1;
     GLint uvLoc = 2;
 
-    if (vbo_coords) {
+    for (GLuint loc = 0; loc < 3; loc++) glDisableVertexAttribArray(loc);
+    if (!layout.empty()) {
+        glBindBuffer(GL_ARRAY_BUFFER, vbo_coords);
+        for (const MeshAttrib& a : layout) {
+            glEnableVertexAttribArray(a.location);
+            glVertexAttribPointer(a.location, a.components, a.type, GL_FALSE, stride, (void*)(size_t)a.offset);
+        }
+    }
+    else if (vbo_coords) {
         glBindBuffer(GL_ARRAY_BUFFER, vbo_coords);
         glEnableVertexAttribArray(posLoc);
         glVertexAttribPointer(posLoc, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
@@ -101,26 +105,34 @@ void Model::render(GLuint mode) {
         glEnableVertexAttribArray(colLoc);
         glVertexAttribPointer(colLoc, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
     }
-    if (vbo_uvs) {  //  uvLoc  
+    if (vbo_uvs) {
         glBindBuffer(GL_ARRAY_BUFFER, vbo_uvs);
         glEnableVertexAttribArray(uvLoc);
         glVertexAttribPointer(uvLoc, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
     }
+    glBindVertexArray(0);
+}
 
-    if (ibo) {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-        glDrawElements(mode, (GLsizei)indices_count, GL_UNSIGNED_INT, 0);
-    }
-    else {
-        glDrawArrays(mode, 0, (GLsizei)verteces_count);
+void Model::render(GLuint mode) {
+    if (shader_programme) glUseProgram(shader_programme);
+    if (texture) {
+        GLint texLoc = glGetUniformLocation(shader_programme, "tex");
+        if (texLoc >= 0) glUniform1i(texLoc, 0);
     }
-
-    //  
-    if (vbo_coords) glDisableVertexAttribArray(posLoc);
-    if (vbo_colors) glDisableVertexAttribArray(colLoc);
-    if (vbo_uvs) glDisableVertexAttribArray(uvLoc);
-
+    draw(mode);
     glBindVertexArray(0);
 }
 
+void Model::draw(GLuint mode) {
+    glBindVertexArray(vao);
+    if (texture) bind_texture(0, *texture, sampler);
+    if (patch_vertices > 0) {
+        glPatchParameteri(GL_PATCH_VERTICES, patch_vertices);
+        mode = GL_PATCHES;
+    }
+    //   -  vao (. load_indices)
+    if (ibo) glDrawElements(mode, (GLsizei)indices_count, GL_UNSIGNED_INT, 0);
+    else glDrawArrays(mode, 0, (GLsizei)verteces_count);
+}
+
 //   :
@@ -8,6 +8,10 @@
 #include <fstream> 
 #include <sstream> 
 #include <vector> 
+#include "Shader.h"
+#include "Texture.h"
+#include "Mesh.h"
+#include "MeshFile.h"
 using namespace std;
 class Model
 {
@@ -29,6 +33,14 @@ public:
 	/// </summary> 
 	///  <param name = "mode">  -  .< / param>
 		void render(GLuint mode = GL_TRIANGLES);
+	/// <summary> 
+	///         : 
+	///    uniform (   tex = 0)   
+	///  (. RenderList::submit).    
+	/// . 
+	/// </summary> 
+	/// <param name="mode"> .</param> 
+	void draw(GLuint mode = GL_TRIANGLES);
 	//       
 	//       
 	/// <summary> 
@@ -36,17 +48,25 @@ public:
 	/// </summary> 
 	/// <param name="verteces">  .</param> 
 	/// <param name="count"> .</param> 
-	void load_coords(glm::vec3* verteces, size_t count);
+	void load_coords(const glm::vec3* verteces, size_t count);
+	/// <summary> 
+	///      ( ).  
+	///   ,     ,  GPU 
+	///   . , uv   . 
+	/// </summary> 
+	/// <param name="verteces">  .</param> 
+	/// <param name="count"> .</param> 
+	void stream_coords(const glm::vec3* verteces, size_t count);
 	/// <summary> 
 	///     . 
 	/// </summary> 
 	/// <param name="colors"> .</param> 
 	/// <param name="count"> .</param> 
-	void load_colors(glm::vec3* colors, size_t count);
+	void load_colors(const glm::vec3* colors, size_t count);
 
 
 
-	void load_uvs(glm::vec2*, size_t);
+	void load_uvs(const glm::vec2*, size_t);
 	GLuint vbo_uvs = 0;    //  
 
 	/// <summary> 
@@ -54,7 +74,19 @@ public:
 	/// </summary> 
 		/// <param name="indices"> .</param> 
 		/// <param name="count"> .</param> 
-		void load_indices(GLuint * indices, size_t count);
+		void load_indices(const GLuint * indices, size_t count);
+	/// <summary> 
+	///    : ,    , 
+	///    . 
+	/// </summary> 
+	/// <param name="mesh">   CPU.</param> 
+	void load_mesh(const SimpleMesh& mesh);
+	/// <summary> 
+	///    .mesh:     
+	///    ,     . 
+	/// </summary> 
+	/// <param name="mesh">  (. OpenMeshFile).</param> 
+	void load_baked(const MeshView& mesh);
 	/// <summary> 
 	///    .      
 	///     
@@ -63,8 +95,24 @@ public:
 	/// </summary> 
 	/// <param name="vect">   </param> 
 	/// <param name="frag">   </param> 
-	void load_shaders(const char* vect, const char* frag);
+	/// <param name="features"> ShaderFeature -   .</param> 
+	void load_shaders(const char* vect, const char* frag, unsigned features = SHADER_VERTEX_COLOR);
 	GLuint get_shader_programme() { return shader_programme; }
+	/// <summary> 
+	///   (  TextureManager).    0 
+	///  ;   -  .     
+	///     ,    . 
+	/// </summary> 
+	/// <param name="tex"> .</param> 
+	/// <param name="kind">,     .</param> 
+	void set_texture(shared_ptr<Texture> tex, SamplerKind kind = SAMPLER_TRILINEAR) { texture = tex; sampler = kind; }
+	/// <summary> 
+	///     n : render  GL_PATCHES  
+	///  . 0 -  . 
+	/// </summary> 
+	/// <param name="n">  .</param> 
+	void set_patch_vertices(int n) { patch_vertices = n; }
+	const shared_ptr<Texture>& get_texture() const { return texture; }
 private:
 	/// <summary> 
 	/// ID   
@@ -93,5 +141,14 @@ private:
 		GLuint vbo_coords = 0;
 		GLuint vbo_colors = 0;
 		GLuint ibo = 0;
+		shared_ptr<Texture> texture;
+		SamplerKind sampler = SAMPLER_TRILINEAR;
+		//    .mesh (vbo_coords   )
+		vector<MeshAttrib> layout;
+		GLsizei stride = 0;
+		int patch_vertices = 0;
+		//          
+		//  ,      
+		void setup_attribs();
 
 };
\ No newline at end of file
@@ -0,0 +1,116 @@
+﻿// PickMesh.cpp
+#include "PickMesh.h"
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define PICK_SSE 1
+#include <emmintrin.h>
+#endif
+
+void PickMesh::build(const glm::vec3* verts, const GLuint* inds, size_t index_count) {
+    count = index_count / 3;
+    size_t blocks = (count + 3) / 4;
+    data.assign(blocks * BLOCK, 0.0f); // хвост - нулевые рёбра, det = 0
+    for (size_t i = 0; i < count; i++) {
+        const glm::vec3& a = verts[inds[3 * i]];
+        glm::vec3 e1 = verts[inds[3 * i + 1]] - a;
+        glm::vec3 e2 = verts[inds[3 * i + 2]] - a;
+        float* b = &data[i / 4 * BLOCK + i % 4];
+        const float c[9] = { a.x, a.y, a.z, e1.x, e1.y, e1.z, e2.x, e2.y, e2.z };
+        for (int k = 0; k < 9; k++) b[4 * k] = c[k];
+    }
+}
+
+void PickMesh::build(const SimpleMesh& mesh) {
+    if (!mesh.inds.empty()) {
+        build(mesh.verts.data(), mesh.inds.data(), mesh.inds.size());
+        return;
+    }
+    vector<GLuint> inds(mesh.verts.size() - mesh.verts.size() % 3);
+    for (size_t i = 0; i < inds.size(); i++) inds[i] = (GLuint)i;
+    build(mesh.verts.data(), inds.data(), inds.size());
+}
+
+void PickMesh::build(const MeshView& mesh) {
+    clear();
+    const MeshFileHeader& h = mesh.header;
+    const MeshAttrib* pos = nullptr;
+    for (uint32_t a = 0; a < h.attrib_count; a++)
+        if (mesh.attribs[a].location == 0) pos = &mesh.attribs[a];
+    if (!pos || pos->components != 3 || pos->type != GL_FLOAT) return;
+    vector<glm::vec3> verts(h.vertex_count);
+    for (uint32_t v = 0; v < h.vertex_count; v++) {
+        const float* p = (const float*)(mesh.vertices + (size_t)v * h.stride + pos->offset);
+        verts[v] = glm::vec3(p[0], p[1], p[2]);
+    }
+    build(verts.data(), mesh.indices, h.index_count);
+}
+
+// Мёллер-Трамбор: p = dir x e2, det = e1 . p, s = origin - v0,
+// u = s . p / det, q = s x e1, v = dir . q / det, t = e2 . q / det.
+float PickMesh::ray_cast(const glm::vec3& origin, const glm::vec3& dir, float max_t) const {
+    size_t blocks = data.size() / BLOCK;
+    bool hit = false;
+    float best = max_t;
+    size_t i = 0;
+#ifdef PICK_SSE
+    const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+    const __m128 dx = _mm_set1_ps(dir.x), dy = _mm_set1_ps(dir.y), dz = _mm_set1_ps(dir.z);
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    __m128 best4 = _mm_set1_ps(max_t);
+    __m128 any = zero;
+    for (; i < blocks; i++) {
+        const float* b = &data[i * BLOCK];
+        __m128 e1x = _mm_loadu_ps(b + 12), e1y = _mm_loadu_ps(b + 16), e1z = _mm_loadu_ps(b + 20);
+        __m128 e2x = _mm_loadu_ps(b + 24), e2y = _mm_loadu_ps(b + 28), e2z = _mm_loadu_ps(b + 32);
+        __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+        __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+        __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+        __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+        __m128 inv = _mm_div_ps(one, det);
+        __m128 sx = _mm_sub_ps(ox, _mm_loadu_ps(b)), sy = _mm_sub_ps(oy, _mm_loadu_ps(b + 4)), sz = _mm_sub_ps(oz, _mm_loadu_ps(b + 8));
+        __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inv);
+        __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+        __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+        __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+        __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inv);
+        __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inv);
+        // при det = 0 u и v - NaN или бесконечность, сравнения их отбрасывают
+        __m128 m = _mm_and_ps(_mm_cmpneq_ps(det, zero), _mm_cmpge_ps(u, zero));
+        m = _mm_and_ps(m, _mm_cmpge_ps(v, zero));
+        m = _mm_and_ps(m, _mm_cmple_ps(_mm_add_ps(u, v), one));
+        m = _mm_and_ps(m, _mm_cmpge_ps(t, zero));
+        m = _mm_and_ps(m, _mm_cmple_ps(t, best4));
+        best4 = _mm_or_ps(_mm_and_ps(m, t), _mm_andnot_ps(m, best4));
+        any = _mm_or_ps(any, m);
+    }
+    best4 = _mm_min_ps(best4, _mm_shuffle_ps(best4, best4, _MM_SHUFFLE(1, 0, 3, 2)));
+    best4 = _mm_min_ps(best4, _mm_shuffle_ps(best4, best4, _MM_SHUFFLE(2, 3, 0, 1)));
+    best = _mm_cvtss_f32(best4);
+    hit = _mm_movemask_ps(any) != 0;
+#endif
+    for (; i < blocks; i++) {
+        const float* b = &data[i * BLOCK];
+        for (int l = 0; l < 4; l++) {
+            glm::vec3 v0(b[l], b[4 + l], b[8 + l]);
+            glm::vec3 e1(b[12 + l], b[16 + l], b[20 + l]);
+            glm::vec3 e2(b[24 + l], b[28 + l], b[32 + l]);
+            glm::vec3 p = glm::cross(dir, e2);
+            float det = glm::dot(e1, p);
+            if (det == 0.0f) continue;
+            float inv = 1.0f / det;
+            glm::vec3 s = origin - v0;
+            float u = glm::dot(s, p) * inv;
+            if (!(u >= 0.0f && u <= 1.0f)) continue;
+            glm::vec3 q = glm::cross(s, e1);
+            float v = glm::dot(dir, q) * inv;
+            if (!(v >= 0.0f && u + v <= 1.0f)) continue;
+            float t = glm::dot(e2, q) * inv;
+            if (t >= 0.0f && t <= best) {
+                best = t;
+                hit = true;
+            }
+        }
+    }
+    return hit ? best : -1.0f;
+}
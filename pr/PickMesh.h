@@ -0,0 +1,44 @@
+﻿#pragma once
+#include "Mesh.h"
+#include "MeshFile.h"
+#include <vector>
+
+using namespace std;
+
+/// <summary>
+/// Копия треугольников сетки на стороне CPU для выбора лучом. Треугольники
+/// хранятся блоками по четыре в виде (v0, e1 = v1 - v0, e2 = v2 - v0),
+/// покомпонентно, так что тест Мёллера-Трамбора проверяет блок за одну
+/// итерацию (SSE) без обращения к индексам. Последний блок дополнен
+/// вырожденными треугольниками, которые тест отбрасывает.
+/// </summary>
+class PickMesh
+{
+public:
+    /// <summary>
+    /// Треугольники из списка индексов (по три на треугольник).
+    /// </summary>
+    void build(const glm::vec3* verts, const GLuint* inds, size_t index_count);
+    void build(const SimpleMesh& mesh);
+
+    /// <summary>
+    /// Треугольники запечённой сетки: позиция - атрибут 0 (три float).
+    /// </summary>
+    void build(const MeshView& mesh);
+
+    void clear() { data.clear(); count = 0; }
+    bool empty() const { return count == 0; }
+    size_t triangle_count() const { return count; }
+
+    /// <summary>
+    /// Ближайшее пересечение луча origin + dir * t (0 &lt;= t &lt;= max_t)
+    /// с треугольниками, с обеих сторон грани. dir не обязан быть
+    /// единичным, t отсчитывается в его длинах.
+    /// </summary>
+    /// <returns>t точки попадания или -1.</returns>
+    float ray_cast(const glm::vec3& origin, const glm::vec3& dir, float max_t) const;
+private:
+    enum { BLOCK = 36 };    // v0, e1, e2 по x, y, z - по 4 float
+    vector<float> data;
+    size_t count = 0;
+};
@@ -0,0 +1,93 @@
+﻿// RenderList.cpp
+#include "RenderList.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    const size_t CHUNK = 256;   // пакетов на задачу построения
+    const uint64_t NO_DRAW = ~0ull;
+}
+
+void RenderList::build(Scene& scene, const glm::mat4& view, const glm::mat4& projection, float alpha, JobSystem& jobs) {
+    glm::mat4 view_proj = projection * view;
+    scene.cull(view_proj, visible, jobs);
+    size_t n = visible.size();
+    packets.resize(n);
+    order.resize(n);
+    size_t chunks = (n + CHUNK - 1) / CHUNK;
+
+    jobs.parallel_for("build draws", 0, chunks, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; c++) {
+            size_t lo = c * CHUNK, hi = std::min(n, lo + CHUNK);
+            for (size_t k = lo; k < hi; k++) {
+                int i = visible[k];
+                DrawPacket& p = packets[k];
+                p.object = i;
+                p.model = scene.objects[i].model.get();
+                order[k].packet = (uint32_t)k;
+                if (!p.model) {
+                    order[k].key = NO_DRAW;
+                    continue;
+                }
+                p.program = p.model->get_shader_programme();
+                p.model_mat = scene.render_matrix(i, alpha);
+                p.mvp = view_proj * p.model_mat;
+
+                // расстояние >= 0: биты float растут вместе со значением
+                float depth = std::max(0.0f, -(view * p.model_mat[3]).z);
+                uint32_t depth_bits;
+                std::memcpy(&depth_bits, &depth, sizeof(depth_bits));
+                const Texture* tex = p.model->get_texture().get();
+                order[k].key = (uint64_t)(p.program & 0xFFFF) << 48 | (uint64_t)((tex ? tex->image().id : 0) & 0xFFFF) << 32 | depth_bits;
+            }
+            std::sort(order.begin() + lo, order.begin() + hi);
+        }
+    });
+
+    // отсортированные куски сливаются попарно, пары - параллельно
+    for (size_t width = CHUNK; width < n; width *= 2) {
+        merged.resize(n);
+        jobs.parallel_for("merge draws", 0, (n + 2 * width - 1) / (2 * width), 1, [&](size_t first, size_t last) {
+            for (size_t pair = first; pair < last; pair++) {
+                size_t lo = pair * 2 * width, mid = std::min(n, lo + width), hi = std::min(n, lo + 2 * width);
+                std::merge(order.begin() + lo, order.begin() + mid, order.begin() + mid, order.begin() + hi,
+                    merged.begin() + lo);
+            }
+        });
+        order.swap(merged);
+    }
+    // объекты без модели отсортировались в конец
+    while (!order.empty() && order.back().key == NO_DRAW) order.pop_back();
+}
+
+void RenderList::submit(float time, glm::vec2 viewport) {
+    GLuint program = 0;
+    const Uniforms* u = nullptr;
+    for (const SortKey& k : order) {
+        const DrawPacket& p = packets[k.packet];
+        if (!u || p.program != program) {
+            program = p.program;
+            auto it = uniforms.find(program);
+            if (it == uniforms.end()) {
+                Uniforms found;
+                found.mvp = glGetUniformLocation(program, "MVP");
+                found.model_mat = glGetUniformLocation(program, "ModelMat");
+                found.time = glGetUniformLocation(program, "u_time");
+                found.viewport = glGetUniformLocation(program, "u_viewport");
+                found.tex = glGetUniformLocation(program, "tex");
+                it = uniforms.emplace(program, found).first;
+            }
+            u = &it->second;
+            // общие для кадра uniform задаются один раз на программу
+            glUseProgram(program);
+            if (u->time >= 0) glUniform1f(u->time, time);
+            if (u->viewport >= 0) glUniform2f(u->viewport, viewport.x, viewport.y);
+            if (u->tex >= 0) glUniform1i(u->tex, 0);   // Model::draw привязывает текстуру к блоку 0
+        }
+        if (u->mvp >= 0) glUniformMatrix4fv(u->mvp, 1, GL_FALSE, glm::value_ptr(p.mvp));
+        if (u->model_mat >= 0) glUniformMatrix4fv(u->model_mat, 1, GL_FALSE, glm::value_ptr(p.model_mat));
+        p.model->draw(GL_TRIANGLES);
+    }
+    glBindVertexArray(0);
+}
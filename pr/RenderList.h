@@ -0,0 +1,62 @@
+﻿#pragma once
+#include "Scene.h"
+#include "JobSystem.h"
+#include <cstdint>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+/// <summary>
+/// Готовая к отправке команда рисования: всё, что нужно GL, посчитано
+/// заранее.
+/// </summary>
+struct DrawPacket {
+    int object;
+    Model* model;
+    GLuint program;
+    glm::mat4 mvp;
+    glm::mat4 model_mat;
+};
+
+/// <summary>
+/// Список рисования кадра в два этапа. build() параллельно (в пуле задач)
+/// отбирает видимые объекты, считает их матрицы и ключи порядка: программа, текстура,
+/// расстояние до камеры (ближние раньше - меньше работы фрагментному
+/// шейдеру при тесте глубины). Каждая задача заполняет и сортирует свой
+/// кусок, затем куски сливаются попарно; сортируются только пары
+/// (ключ, номер пакета), сами пакеты не перемещаются. submit() в потоке
+/// GL только проигрывает пакеты, переключая программу при смене и не
+/// запрашивая положения uniform заново.
+/// </summary>
+class RenderList
+{
+public:
+    /// <param name="alpha">Доля шага симуляции для render_matrix().</param>
+    void build(Scene& scene, const glm::mat4& view, const glm::mat4& projection, float alpha, JobSystem& jobs);
+
+    /// <summary>
+    /// Отправка пакетов в GL. Вызывается в потоке с GL контекстом.
+    /// </summary>
+    /// <param name="time">Значение u_time.</param>
+    /// <param name="viewport">Значение u_viewport (размер окна в пикселях).</param>
+    void submit(float time, glm::vec2 viewport);
+
+    size_t size() const { return order.size(); }
+    const DrawPacket& draw(size_t k) const { return packets[order[k].packet]; }
+private:
+    struct Uniforms {
+        GLint mvp, model_mat, time, viewport, tex;
+    };
+    struct SortKey {
+        uint64_t key;
+        uint32_t packet;
+        bool operator<(const SortKey& o) const { return key != o.key ? key < o.key : packet < o.packet; }
+    };
+
+    vector<int> visible;
+    vector<DrawPacket> packets;   // в порядке visible
+    vector<SortKey> order;        // порядок отправки
+    vector<SortKey> merged;
+    map<GLuint, Uniforms> uniforms;   // программы живут до ShaderCache::clear()
+};
@@ -0,0 +1,208 @@
+﻿// Rope.cpp
+#include "Rope.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define ROPE_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+    size_t round4(size_t n) {
+        return (n + 3) & ~(size_t)3;
+    }
+}
+
+void RopeSystem::resize(size_t n) {
+    // запас в 4 элемента: отрезок читает и следующую частицу
+    size_t cap = round4(n) + 4;
+    for (vector<float>* v : { &x, &y, &z, &px, &py, &pz, &tx, &ty, &tz, &inv_mass, &rest,
+                              &share_a[0], &share_a[1], &share_b_prev[0], &share_b_prev[1], &cx, &cy, &cz })
+        v->resize(cap, 0.0f);
+}
+
+RopeSystem::RopeId RopeSystem::add(const vector<glm::vec3>& points) {
+    Rope r;
+    r.first = (int)used;
+    r.count = (int)std::max<size_t>(points.size(), 2);
+    used += r.count;
+    resize(used);
+
+    for (int i = 0; i < r.count; i++) {
+        size_t k = r.first + i;
+        glm::vec3 p = points[std::min<size_t>(i, points.size() - 1)];
+        x[k] = px[k] = tx[k] = p.x;
+        y[k] = py[k] = ty[k] = p.y;
+        z[k] = pz[k] = tz[k] = p.z;
+        inv_mass[k] = (i == 0 || i == r.count - 1) ? 0.0f : 1.0f;
+    }
+    for (int i = 0; i + 1 < r.count; i++) {
+        size_t k = r.first + i;
+        rest[k] = std::sqrt((x[k + 1] - x[k]) * (x[k + 1] - x[k]) + (y[k + 1] - y[k]) * (y[k + 1] - y[k]) +
+            (z[k + 1] - z[k]) * (z[k + 1] - z[k]));
+        float w = inv_mass[k] + inv_mass[k + 1];
+        int pass = (int)(k & 1);
+        share_a[pass][k] = w > 0.0f ? inv_mass[k] / w : 0.0f;
+        share_b_prev[pass][k + 1] = w > 0.0f ? inv_mass[k + 1] / w : 0.0f;
+    }
+    ropes.push_back(r);
+    return (RopeId)ropes.size() - 1;
+}
+
+void RopeSystem::clear() {
+    *this = RopeSystem();
+}
+
+void RopeSystem::pin_ends(RopeId id, const glm::vec3& start, const glm::vec3& end) {
+    const Rope& r = ropes[id];
+    size_t a = r.first, b = r.first + r.count - 1;
+    x[a] = px[a] = start.x; y[a] = py[a] = start.y; z[a] = pz[a] = start.z;
+    x[b] = px[b] = end.x; y[b] = py[b] = end.y; z[b] = pz[b] = end.z;
+}
+
+void RopeSystem::save_previous() {
+    std::copy(x.begin(), x.begin() + used, tx.begin());
+    std::copy(y.begin(), y.begin() + used, ty.begin());
+    std::copy(z.begin(), z.begin() + used, tz.begin());
+}
+
+void RopeSystem::simulate(float dt, int substeps) {
+    if (!used || substeps < 1) return;
+    float h = dt / substeps;
+    for (int s = 0; s < substeps; s++) step(h);
+}
+
+void RopeSystem::step(float dt) {
+    size_t n = round4(used);
+    float* X = x.data(); float* Y = y.data(); float* Z = z.data();
+    float* PX = px.data(); float* PY = py.data(); float* PZ = pz.data();
+    const float* W = inv_mass.data();
+    glm::vec3 g = gravity * (dt * dt);
+
+    // Верле: x' = x + (x - x_prev) * damping + g * dt^2, закреплённые
+    // частицы (W = 0) стоят на месте.
+#ifdef ROPE_SSE
+    __m128 damp = _mm_set1_ps(damping);
+    __m128 gx = _mm_set1_ps(g.x), gy = _mm_set1_ps(g.y), gz = _mm_set1_ps(g.z);
+    __m128 floor4 = _mm_set1_ps(floor_y);
+    for (size_t i = 0; i < n; i += 4) {
+        __m128 w = _mm_loadu_ps(W + i);
+        __m128 cx4 = _mm_loadu_ps(X + i), cy4 = _mm_loadu_ps(Y + i), cz4 = _mm_loadu_ps(Z + i);
+        __m128 vx = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(cx4, _mm_loadu_ps(PX + i)), damp), gx);
+        __m128 vy = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(cy4, _mm_loadu_ps(PY + i)), damp), gy);
+        __m128 vz = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(cz4, _mm_loadu_ps(PZ + i)), damp), gz);
+        _mm_storeu_ps(PX + i, cx4);
+        _mm_storeu_ps(PY + i, cy4);
+        _mm_storeu_ps(PZ + i, cz4);
+        __m128 ny = _mm_add_ps(cy4, _mm_mul_ps(vy, w));
+        ny = _mm_add_ps(ny, _mm_mul_ps(_mm_sub_ps(_mm_max_ps(ny, floor4), ny), w));
+        _mm_storeu_ps(X + i, _mm_add_ps(cx4, _mm_mul_ps(vx, w)));
+        _mm_storeu_ps(Y + i, ny);
+        _mm_storeu_ps(Z + i, _mm_add_ps(cz4, _mm_mul_ps(vz, w)));
+    }
+#else
+    for (size_t i = 0; i < n; i++) {
+        float vx = (X[i] - PX[i]) * damping + g.x;
+        float vy = (Y[i] - PY[i]) * damping + g.y;
+        float vz = (Z[i] - PZ[i]) * damping + g.z;
+        PX[i] = X[i]; PY[i] = Y[i]; PZ[i] = Z[i];
+        X[i] += vx * W[i];
+        Y[i] += vy * W[i];
+        Z[i] += vz * W[i];
+        if (W[i] > 0.0f && Y[i] < floor_y) Y[i] = floor_y;
+    }
+#endif
+
+    for (int it = 0; it < iterations; it++) {
+        solve(share_a[0], share_b_prev[0]);
+        solve(share_a[1], share_b_prev[1]);
+    }
+}
+
+void RopeSystem::solve(const vector<float>& sa, const vector<float>& sb_prev) {
+    size_t n = round4(used);
+    float* X = x.data(); float* Y = y.data(); float* Z = z.data();
+    float* CX = cx.data(); float* CY = cy.data(); float* CZ = cz.data();
+    const float* R = rest.data();
+    const float* SA = sa.data();
+    const float* SB = sb_prev.data();
+
+    // Поправка отрезка k: d * (1 - rest / |d|), d = x[k+1] - x[k].
+    // Пишется в C[k + 1], чтобы частица i читала поправки обоих своих
+    // отрезков из C[i] и C[i + 1] без выхода за начало массива.
+#ifdef ROPE_SSE
+    __m128 eps = _mm_set1_ps(1e-12f);
+    __m128 half = _mm_set1_ps(0.5f), three_halves = _mm_set1_ps(1.5f), one = _mm_set1_ps(1.0f);
+    for (size_t i = 0; i < n; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(X + i + 1), _mm_loadu_ps(X + i));
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(Y + i + 1), _mm_loadu_ps(Y + i));
+        __m128 dz = _mm_sub_ps(_mm_loadu_ps(Z + i + 1), _mm_loadu_ps(Z + i));
+        __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_add_ps(_mm_mul_ps(dz, dz), eps));
+        // 1 / |d|: приближение rsqrt и один шаг Ньютона
+        __m128 r = _mm_rsqrt_ps(d2);
+        r = _mm_mul_ps(r, _mm_sub_ps(three_halves, _mm_mul_ps(_mm_mul_ps(half, d2), _mm_mul_ps(r, r))));
+        __m128 k = _mm_sub_ps(one, _mm_mul_ps(_mm_loadu_ps(R + i), r));
+        _mm_storeu_ps(CX + i + 1, _mm_mul_ps(dx, k));
+        _mm_storeu_ps(CY + i + 1, _mm_mul_ps(dy, k));
+        _mm_storeu_ps(CZ + i + 1, _mm_mul_ps(dz, k));
+    }
+    for (size_t i = 0; i < n; i += 4) {
+        __m128 a = _mm_loadu_ps(SA + i), b = _mm_loadu_ps(SB + i);
+        _mm_storeu_ps(X + i, _mm_add_ps(_mm_loadu_ps(X + i),
+            _mm_sub_ps(_mm_mul_ps(a, _mm_loadu_ps(CX + i + 1)), _mm_mul_ps(b, _mm_loadu_ps(CX + i)))));
+        _mm_storeu_ps(Y + i, _mm_add_ps(_mm_loadu_ps(Y + i),
+            _mm_sub_ps(_mm_mul_ps(a, _mm_loadu_ps(CY + i + 1)), _mm_mul_ps(b, _mm_loadu_ps(CY + i)))));
+        _mm_storeu_ps(Z + i, _mm_add_ps(_mm_loadu_ps(Z + i),
+            _mm_sub_ps(_mm_mul_ps(a, _mm_loadu_ps(CZ + i + 1)), _mm_mul_ps(b, _mm_loadu_ps(CZ + i)))));
+    }
+#else
+    for (size_t i = 0; i < n; i++) {
+        float dx = X[i + 1] - X[i], dy = Y[i + 1] - Y[i], dz = Z[i + 1] - Z[i];
+        float k = 1.0f - R[i] / std::sqrt(dx * dx + dy * dy + dz * dz + 1e-12f);
+        CX[i + 1] = dx * k;
+        CY[i + 1] = dy * k;
+        CZ[i + 1] = dz * k;
+    }
+    for (size_t i = 0; i < n; i++) {
+        X[i] += SA[i] * CX[i + 1] - SB[i] * CX[i];
+        Y[i] += SA[i] * CY[i + 1] - SB[i] * CY[i];
+        Z[i] += SA[i] * CZ[i + 1] - SB[i] * CZ[i];
+    }
+#endif
+}
+
+glm::vec3 RopeSystem::position(RopeId id, int i, float alpha) const {
+    size_t k = ropes[id].first + i;
+    return glm::vec3(tx[k] + (x[k] - tx[k]) * alpha,
+        ty[k] + (y[k] - ty[k]) * alpha,
+        tz[k] + (z[k] - tz[k]) * alpha);
+}
+
+void RopeSystem::bounds(RopeId id, glm::vec3& lo, glm::vec3& hi) const {
+    const Rope& r = ropes[id];
+    lo = hi = glm::vec3(x[r.first], y[r.first], z[r.first]);
+    for (int i = r.first + 1; i < r.first + r.count; i++) {
+        glm::vec3 p(x[i], y[i], z[i]);
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+    }
+}
+
+void RopeSystem::points(RopeId id, float alpha, glm::vec3* out) const {
+    for (int i = 0; i < ropes[id].count; i++) out[i] = position(id, i, alpha);
+}
+
+void RopeSystem::build_ribbon(RopeId id, float alpha, float half_width, glm::vec3* out) const {
+    int n = ropes[id].count;
+    glm::vec3 side(1.0f, 0.0f, 0.0f);
+    for (int i = 0; i < n; i++) {
+        glm::vec3 p = position(id, i, alpha);
+        glm::vec3 tangent = position(id, std::min(i + 1, n - 1), alpha) - position(id, std::max(i - 1, 0), alpha);
+        glm::vec3 c = glm::cross(tangent, glm::vec3(0, 1, 0));
+        float l = glm::length(c);
+        if (l > 1e-6f) side = c / l; // на вертикальном участке - ориентация соседа
+        out[i * 2] = p - side * half_width;
+        out[i * 2 + 1] = p + side * half_width;
+    }
+}
@@ -0,0 +1,92 @@
+﻿#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+
+using namespace std;
+
+/// <summary>
+/// Верёвки на частицах: интегрирование Верле с гравитацией и
+/// ограничения длины отрезков (position based dynamics). Частицы всех
+/// верёвок лежат подряд в общих массивах по компонентам, так что шаг
+/// симуляции - несколько плотных циклов по всем частицам сразу, по четыре
+/// за итерацию (SSE). Отрезки решаются в два прохода, чётные и нечётные:
+/// внутри прохода они не делят частиц и обновляются независимо, а
+/// сходимость как у последовательного Гаусса-Зейделя.
+/// </summary>
+class RopeSystem
+{
+public:
+    typedef int RopeId;
+
+    /// <summary>
+    /// Новая верёвка, лежащая вдоль ломаной points (не меньше двух точек).
+    /// Длина отрезков в покое берётся из ломаной. Концы закреплены.
+    /// </summary>
+    RopeId add(const vector<glm::vec3>& points);
+    void clear();
+    size_t size() const { return ropes.size(); }
+    int particle_count(RopeId r) const { return ropes[r].count; }
+
+    /// <summary>
+    /// Положение закреплённых концов (обычно вслед за объектами сцены).
+    /// </summary>
+    void pin_ends(RopeId r, const glm::vec3& start, const glm::vec3& end);
+
+    glm::vec3 gravity = glm::vec3(0.0f, -9.81f, 0.0f);
+    float damping = 0.999f;       // доля скорости, сохраняемая за шаг
+    float floor_y = -1e30f;       // частицы не опускаются ниже
+    int iterations = 4;           // проходов по ограничениям за шаг
+
+    /// <summary>
+    /// Запоминание положения частиц как состояния предыдущего тика (для
+    /// интерполяции при отрисовке).
+    /// </summary>
+    void save_previous();
+
+    /// <summary>
+    /// Продвижение всех верёвок на dt, разбитое на substeps шагов Верле.
+    /// </summary>
+    void simulate(float dt, int substeps);
+
+    /// <summary>
+    /// Положение частицы между сохранённым save_previous() (alpha = 0) и
+    /// текущим (alpha = 1).
+    /// </summary>
+    glm::vec3 position(RopeId r, int i, float alpha = 1.0f) const;
+    void bounds(RopeId r, glm::vec3& lo, glm::vec3& hi) const;
+
+    /// <summary>
+    /// Положения всех particle_count(r) частиц на момент alpha.
+    /// </summary>
+    void points(RopeId r, float alpha, glm::vec3* out) const;
+
+    /// <summary>
+    /// Вершины плоской ленты вдоль верёвки, в том же порядке, что у
+    /// make_cable: по две на частицу, 2 * particle_count(r) штук.
+    /// </summary>
+    /// <param name="half_width">Половина ширины ленты.</param>
+    void build_ribbon(RopeId r, float alpha, float half_width, glm::vec3* out) const;
+private:
+    struct Rope {
+        int first;
+        int count;
+    };
+
+    void step(float dt);
+    void solve(const vector<float>& share_a, const vector<float>& share_b_prev);
+    void resize(size_t n);
+
+    vector<Rope> ropes;
+    size_t used = 0;                // частиц во всех верёвках
+    vector<float> x, y, z;          // текущее положение
+    vector<float> px, py, pz;       // положение на прошлом шаге Верле
+    vector<float> tx, ty, tz;       // положение на прошлом тике
+    vector<float> inv_mass;         // 0 - частица закреплена
+    // Отрезок k соединяет частицы k и k + 1. Доли поправки, которые
+    // получают его концы, отдельно для чётного и нечётного прохода (у
+    // отрезков другой чётности и на стыке верёвок они нулевые). Доля
+    // второго конца хранится со сдвигом на одну частицу.
+    vector<float> rest;
+    vector<float> share_a[2], share_b_prev[2];
+    vector<float> cx, cy, cz;       // поправки отрезков, тоже со сдвигом
+};
@@ -0,0 +1,400 @@
+﻿// Scene.cpp
+#include "Scene.h"
+#include "Assets.h"
+#include "MeshFile.h"
+#include "Tube.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <iostream>
+
+namespace {
+    const float ROPE_RATE = 1000.0f;         // шагов симуляции верёвок в секунду
+    const float CABLE_HALF_WIDTH = 0.015f;   // как у make_cable
+
+    // точки кривой кабеля - те же, что у вершин make_cable
+    vector<glm::vec3> cable_points(const MeshDesc& m) {
+        vector<glm::vec3> points;
+        for (int i = 0; i <= m.segments; i++) {
+            float t = (float)i / m.segments;
+            points.push_back((1 - t) * (1 - t) * m.p0 + 2 * (1 - t) * t * m.p1 + t * t * m.p2);
+        }
+        return points;
+    }
+
+    SimpleMesh build_mesh(const MeshDesc& m) {
+        switch (m.generator) {
+        case MESH_BOX: return make_box(glm::vec3(0.0f), m.size, m.color);
+        case MESH_TEXTURED_BOX: return make_textured_box(glm::vec3(0.0f), m.size);
+        case MESH_ROOM: return make_colored_room();
+        case MESH_CABLE:
+            if (m.radial > 0) return make_tube(cable_points(m), m.radius, m.radial, m.color);
+            return make_cable(m.p0, m.p1, m.p2, m.segments, m.color);
+        default: return SimpleMesh();
+        }
+    }
+
+    // Сетка объекта на стороне CPU: запечённая (указывает в отображённый
+    // файл) или построенная генератором.
+    struct BuiltMesh {
+        SimpleMesh mesh;
+        MeshView baked;
+        bool has_baked = false;
+        PickMesh pick;
+        glm::vec3 lo = glm::vec3(0.0f), hi = glm::vec3(0.0f);
+    };
+
+    void mesh_bounds(const SimpleMesh& mesh, glm::vec3& lo, glm::vec3& hi) {
+        lo = hi = mesh.verts.empty() ? glm::vec3(0.0f) : mesh.verts[0];
+        for (const glm::vec3& v : mesh.verts) {
+            lo = glm::min(lo, v);
+            hi = glm::max(hi, v);
+        }
+    }
+}
+
+bool Scene::load(const char* name, GLFWwindow* window, TextureManager& textures, MeshImporter& importer, JobSystem& jobs) {
+    AssetBlob blob = LoadAsset(name);
+    if (!blob) {
+        std::cerr << "Scene " << name << " not found" << std::endl;
+        return false;
+    }
+    SceneDesc desc;
+    string error;
+    if (!ParseScene((const char*)blob.data, blob.size, desc, error)) {
+        std::cerr << name << ": " << error << std::endl;
+        return false;
+    }
+
+    this->jobs = &jobs;
+    camera_position = desc.camera_position;
+    camera_yaw = desc.camera_yaw;
+    camera_pitch = desc.camera_pitch;
+
+    // ссылки по именам разрешаются сразу; родитель только выше по файлу,
+    // поэтому иерархия без циклов, а родители идут раньше детей
+    objects.clear();
+    transforms.clear();
+    tree.clear();
+    proxies.assign(desc.objects.size(), -1);
+    unbounded.clear();
+    ropes.clear();
+    rope_links.clear();
+    objects.resize(desc.objects.size());
+    auto index_of = [&](const string& n, size_t limit) {
+        for (size_t j = 0; j < limit; j++)
+            if (desc.objects[j].name == n) return (int)j;
+        return -1;
+    };
+    for (size_t i = 0; i < desc.objects.size(); i++) {
+        const ObjectDesc& d = desc.objects[i];
+        SceneObject& obj = objects[i];
+        obj.name = d.name;
+        obj.controlled = d.controlled;
+        obj.draggable = d.draggable;
+        int parent = -1;
+        if (!d.parent.empty() && (parent = index_of(d.parent, i)) < 0) {
+            std::cerr << name << ": line " << d.line << ": parent '" << d.parent << "' must be declared above" << std::endl;
+            return false;
+        }
+        transforms.create(parent);
+        unbounded.push_back((int)i);
+        transforms.set_position((int)i, d.position);
+        transforms.set_rotation((int)i, d.rotation);
+        transforms.set_scale((int)i, d.scale);
+        if (!d.carry.empty() && (obj.carry = index_of(d.carry, desc.objects.size())) < 0) {
+            std::cerr << name << ": line " << d.line << ": unknown object '" << d.carry << "'" << std::endl;
+            return false;
+        }
+    }
+    update_transforms();
+
+    for (size_t i = 0; i < desc.objects.size(); i++) {
+        const ObjectDesc& d = desc.objects[i];
+        if (d.rope_start.empty()) continue;
+        if (d.mesh.generator != MESH_CABLE || !d.model.empty() || !d.parent.empty()) {
+            std::cerr << name << ": line " << d.line << ": rope needs a cable mesh in world coordinates (no model or parent)" << std::endl;
+            return false;
+        }
+        RopeLink link;
+        link.object = (int)i;
+        link.anchor[0] = index_of(d.rope_start, desc.objects.size());
+        link.anchor[1] = index_of(d.rope_end, desc.objects.size());
+        if (link.anchor[0] < 0 || link.anchor[1] < 0) {
+            std::cerr << name << ": line " << d.line << ": unknown rope anchor" << std::endl;
+            return false;
+        }
+        vector<glm::vec3> points = cable_points(d.mesh);
+        link.rope = ropes.add(points);
+        link.patches = (d.features & SHADER_TESSELLATED) != 0;
+        link.radial = link.patches ? 0 : d.mesh.radial;
+        link.radius = link.radial ? d.mesh.radius : CABLE_HALF_WIDTH;
+        link.offset[0] = points.front() - world_position(link.anchor[0]);
+        link.offset[1] = points.back() - world_position(link.anchor[1]);
+        rope_links.push_back(link);
+    }
+
+    // Граф загрузки: сетка строится (или читается из .mesh) в рабочем
+    // потоке, загрузка в GL, компиляция шейдеров и постановка текстур в
+    // очередь идут в главном; материал объекта ждёт свою сетку, шейдер и
+    // текстуру. wait() выполняет задачи главного потока по мере готовности.
+    size_t n = desc.objects.size();
+    vector<BuiltMesh> built(n);
+    vector<shared_ptr<Texture>> texs(n);
+    map<unsigned, JobSystem::JobId> shader_jobs;
+
+    for (size_t i = 0; i < n; i++) {
+        const ObjectDesc& d = desc.objects[i];
+        unsigned features = d.features;
+
+        JobSystem::JobId build = jobs.add("build " + d.name, [&d, &b = built[i]] {
+            if (!d.model.empty())
+                b.has_baked = OpenMeshFile(("models/" + d.model + ".mesh").c_str(), b.baked);
+            if (b.has_baked) {
+                const MeshFileHeader& h = b.baked.header;
+                b.lo = glm::vec3(h.bounds_min[0], h.bounds_min[1], h.bounds_min[2]);
+                b.hi = glm::vec3(h.bounds_max[0], h.bounds_max[1], h.bounds_max[2]);
+                b.pick.build(b.baked);
+            }
+            else if (d.mesh.generator == MESH_CABLE && (d.features & SHADER_TESSELLATED)) {
+                b.mesh = make_cable_patches(cable_points(d.mesh), d.mesh.color);
+                mesh_bounds(b.mesh, b.lo, b.hi);
+            }
+            else {
+                b.mesh = build_mesh(d.mesh);
+                mesh_bounds(b.mesh, b.lo, b.hi);
+                if (d.rope_start.empty()) b.pick.build(b.mesh); // форма верёвки меняется
+            }
+        });
+
+        if (!shader_jobs.count(features)) {
+            shader_jobs[features] = jobs.add("shader " + to_string(features), [features] {
+                ShaderCache::instance().get("vs.glsl", "fs.glsl", features);
+            }, {}, true);
+        }
+
+        vector<JobSystem::JobId> material_deps = { shader_jobs[features] };
+        if (!d.texture.empty()) {
+            material_deps.push_back(jobs.add("texture " + d.texture, [&d, &tex = texs[i], &textures] {
+                tex = textures.load(d.texture.c_str());
+            }, {}, true));
+        }
+
+        JobSystem::JobId upload = jobs.add("upload " + d.name, [this, i, &d, &b = built[i], window, &importer, &textures] {
+            SceneObject& obj = objects[i];
+            obj.model = make_unique<Model>(window);
+            bool baked = b.has_baked;
+            if (baked) obj.model->load_baked(b.baked);
+            else if (!b.mesh.verts.empty()) obj.model->load_mesh(b.mesh);
+            if (d.features & SHADER_TESSELLATED) obj.model->set_patch_vertices(4);
+            if (baked || !b.mesh.verts.empty()) set_bounds(i, b.lo, b.hi);
+            obj.pick = std::move(b.pick);
+            b = BuiltMesh(); // отображение файла и копия на CPU больше не нужны
+            if (!baked && !d.model.empty()) queue_import(i, d, importer, textures);
+        }, { build }, true);
+        material_deps.push_back(upload);
+
+        // программа к этому моменту уже в кэше, load_shaders её только находит
+        jobs.add("material " + d.name, [this, i, features, &d, &tex = texs[i]] {
+            objects[i].model->load_shaders("vs.glsl", "fs.glsl", features);
+            if (tex) objects[i].model->set_texture(tex, (SamplerKind)d.sampler);
+        }, material_deps, true);
+    }
+    jobs.wait();
+
+    std::cout << "Scene " << name << " loaded:" << std::endl;
+    jobs.timeline(std::cout);
+    return true;
+}
+
+// Исходник модели импортируется в фоне и по готовности заменяет сетку.
+void Scene::queue_import(size_t i, const ObjectDesc& d, MeshImporter& importer, TextureManager& textures) {
+    string path = "models/" + d.model + ".obj";
+    if (!AssetExists(path.c_str())) return;
+    unsigned features = d.features;
+    SamplerKind sampler = (SamplerKind)d.sampler;
+    importer.import(path.c_str(), [this, i, features, sampler, &textures](ImportResult& r) {
+        if (!r.ok) return;
+        SceneObject& o = objects[i];
+        glm::vec3 lo, hi;
+        mesh_bounds(r.mesh, lo, hi);
+        o.model->load_mesh(r.mesh);
+        o.pick.build(r.mesh);
+        set_bounds(i, lo, hi);
+        if (!r.texture.empty() && AssetExists(r.texture.c_str())) {
+            o.model->set_texture(textures.load(r.texture.c_str()), sampler);
+            o.model->load_shaders("vs.glsl", "fs.glsl", features | SHADER_TEXTURED);
+        }
+    });
+}
+
+// Границы меняются и когда импорт заменяет сетку, поэтому опоры
+// проверяются заново.
+void Scene::set_bounds(size_t i, const glm::vec3& lo, const glm::vec3& hi) {
+    transforms.set_bounds((int)i, lo, hi);
+    for (size_t j = 0; j < objects.size(); j++) keep_carried(j);
+}
+
+void Scene::update_transforms() {
+    transforms.update();
+    transforms.take_moved(moved);
+    for (int e : moved) {
+        if (!transforms.has_bounds(e)) continue;
+        Aabb box;
+        transforms.world_bounds(e, box.lo, box.hi);
+        if (proxies[e] >= 0) {
+            tree.move(proxies[e], box);
+            continue;
+        }
+        proxies[e] = tree.insert(box, e);
+        unbounded.erase(std::remove(unbounded.begin(), unbounded.end(), e), unbounded.end());
+    }
+}
+
+void Scene::cull(const glm::mat4& view_proj, vector<int>& visible, JobSystem& jobs) {
+    // по несколько частей на поток, чтобы неравные части уравновешивались
+    tree.split((size_t)(jobs.thread_count() + 1) * 4, subtrees);
+    subtree_visible.resize(subtrees.size());
+    jobs.parallel_for("cull", 0, subtrees.size(), 1, [this, &view_proj](size_t b, size_t e) {
+        for (size_t k = b; k < e; k++) tree.query_frustum(view_proj, subtree_visible[k], subtrees[k]);
+    });
+    visible.clear();
+    for (size_t k = 0; k < subtrees.size(); k++)
+        visible.insert(visible.end(), subtree_visible[k].begin(), subtree_visible[k].end());
+    visible.insert(visible.end(), unbounded.begin(), unbounded.end());
+    // по возрастанию индекса: дальше матрицы читаются подряд
+    std::sort(visible.begin(), visible.end());
+}
+
+int Scene::ray_cast(const glm::vec3& origin, const glm::vec3& dir, float max_t, float* t_hit) const {
+    glm::vec3 inv(1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z);
+    // в дереве толстые AABB, попадание проверяется по точным
+    return tree.ray_cast(origin, dir, max_t, [&](int e) {
+        Aabb box;
+        transforms.world_bounds(e, box.lo, box.hi);
+        float t;
+        return ray_aabb(origin, inv, box, max_t, &t) ? t : -1.0f;
+    }, t_hit);
+}
+
+int Scene::pick(const glm::vec3& origin, const glm::vec3& dir, float max_t, float* t_hit) const {
+    glm::vec3 inv(1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z);
+    return tree.ray_cast(origin, dir, max_t, [&](int e) {
+        const PickMesh& mesh = objects[e].pick;
+        Aabb box;
+        transforms.world_bounds(e, box.lo, box.hi);
+        float t;
+        if (mesh.empty() || !ray_aabb(origin, inv, box, max_t, &t)) return -1.0f;
+        // Луч переносится в локальные координаты объекта. Направление не
+        // нормируется, поэтому t у точки попадания в обеих системах одно.
+        glm::mat4 to_local = glm::inverse(transforms.world(e));
+        glm::vec3 o(to_local * glm::vec4(origin, 1.0f));
+        glm::vec3 d(to_local * glm::vec4(dir, 0.0f));
+        return mesh.ray_cast(o, d, max_t);
+    }, t_hit);
+}
+
+int Scene::drag_handle(size_t i) const {
+    for (int e = (int)i; e >= 0; e = transforms.parent_of(e))
+        if (objects[e].draggable) return e;
+    return -1;
+}
+
+void Scene::drag(size_t i, glm::vec3 delta) {
+    if (delta == glm::vec3(0.0f)) return;
+    set_position(i, transforms.position((int)i) + delta);
+    keep_carried(i);
+    // опоры перевозимого объекта едут за ним
+    for (size_t j = 0; j < objects.size(); j++)
+        if (objects[j].carry == (int)i) keep_carried(j);
+}
+
+void Scene::overlap(const Aabb& box, vector<int>& found) const {
+    tree.query(box, found);
+    // отбор по точным AABB
+    found.erase(std::remove_if(found.begin(), found.end(), [&](int e) {
+        glm::vec3 lo, hi;
+        transforms.world_bounds(e, lo, hi);
+        return lo.x > box.hi.x || box.lo.x > hi.x || lo.y > box.hi.y || box.lo.y > hi.y ||
+            lo.z > box.hi.z || box.lo.z > hi.z;
+    }), found.end());
+}
+
+void Scene::simulate(float dt) {
+    if (rope_links.empty()) return;
+    for (const RopeLink& l : rope_links)
+        ropes.pin_ends(l.rope, world_position(l.anchor[0]) + l.offset[0], world_position(l.anchor[1]) + l.offset[1]);
+    ropes.simulate(dt, std::max(1, (int)std::ceil(dt * ROPE_RATE)));
+
+    // лента или трубка выступает за осевую линию на полширины
+    for (const RopeLink& l : rope_links) {
+        glm::vec3 lo, hi;
+        ropes.bounds(l.rope, lo, hi);
+        transforms.set_bounds(l.object, lo - glm::vec3(l.radius), hi + glm::vec3(l.radius));
+    }
+    update_transforms();
+}
+
+void Scene::build_ropes(float alpha, vector<vector<glm::vec3>>& verts) {
+    verts.resize(rope_links.size());
+    auto build = [this, alpha, &verts](size_t b, size_t e) {
+        for (size_t k = b; k < e; k++) {
+            RopeLink& l = rope_links[k];
+            vector<glm::vec3>& out = verts[k];
+            int n = ropes.particle_count(l.rope);
+            if (l.patches) {
+                out.resize(n);
+                ropes.points(l.rope, alpha, out.data());
+            }
+            else if (l.radial) {
+                l.axis.resize(n);
+                ropes.points(l.rope, alpha, l.axis.data());
+                out.resize((size_t)n * l.radial);
+                l.tube.build(l.axis.data(), n, l.radius, l.radial, out.data());
+            }
+            else {
+                out.resize(2 * n);
+                ropes.build_ribbon(l.rope, alpha, CABLE_HALF_WIDTH, out.data());
+            }
+        }
+    };
+    if (jobs) jobs->parallel_for("build ropes", 0, rope_links.size(), 1, build);
+    else build(0, rope_links.size());
+}
+
+void Scene::stream_ropes(const vector<vector<glm::vec3>>& verts) {
+    for (size_t k = 0; k < rope_links.size() && k < verts.size(); k++) {
+        Model* m = objects[rope_links[k].object].model.get();
+        if (m) m->stream_coords(verts[k].data(), verts[k].size());
+    }
+}
+
+void Scene::move_controlled(glm::vec3 delta) {
+    if (delta == glm::vec3(0.0f)) return;
+    for (size_t i = 0; i < objects.size(); i++) {
+        if (!objects[i].controlled) continue;
+        set_position(i, transforms.position((int)i) + delta);
+        keep_carried(i);
+    }
+}
+
+// Опора сдвигается так, чтобы мировой AABB перевозимого объекта на XZ
+// оставался внутри её собственного (сдвиг считается в мировых осях, у
+// родителя опоры не должно быть поворота и масштаба).
+void Scene::keep_carried(size_t i) {
+    const SceneObject& obj = objects[i];
+    if (obj.carry < 0) return;
+    update_transforms();
+    glm::vec3 c_lo, c_hi, lo, hi;
+    transforms.world_bounds(obj.carry, c_lo, c_hi);
+    transforms.world_bounds((int)i, lo, hi);
+    glm::vec3 p = transforms.position((int)i);
+    for (int a = 0; a < 3; a += 2) {
+        float min_shift = c_hi[a] - hi[a];
+        float max_shift = c_lo[a] - lo[a];
+        if (min_shift > max_shift) continue; // объект шире опоры
+        p[a] += std::min(std::max(0.0f, min_shift), max_shift);
+    }
+    set_position(i, p);
+}
@@ -0,0 +1,180 @@
+﻿#pragma once
+#include "SceneFile.h"
+#include "Model.h"
+#include "Texture.h"
+#include "MeshImporter.h"
+#include "JobSystem.h"
+#include "TransformStore.h"
+#include "Rope.h"
+#include "Tube.h"
+#include "AabbTree.h"
+#include "PickMesh.h"
+#include <memory>
+#include <vector>
+#include <string>
+
+using namespace std;
+
+/// <summary>
+/// Объект сцены. Его индекс в Scene::objects совпадает с сущностью в
+/// Scene::transforms, где хранятся положение, иерархия и границы.
+/// </summary>
+struct SceneObject {
+    string name;
+    unique_ptr<Model> model;
+    int carry = -1;
+    bool controlled = false;
+    bool draggable = false;
+    PickMesh pick;          // треугольники модели в локальных координатах
+};
+
+/// <summary>
+/// Сцена, собранная из файла описания (см. SceneFile.h).
+/// </summary>
+class Scene
+{
+public:
+    /// <summary>
+    /// Разбор файла и загрузка всех объектов через граф задач: сетки
+    /// строятся или читаются из .mesh в пуле jobs, загрузка в GL и
+    /// компиляция шейдеров идут в этом потоке, материал объекта ждёт свою
+    /// сетку, шейдер и текстуру. Декодирование текстур и импорт .obj
+    /// продолжаются в фоне и после возврата. Отчёт о задачах печатается
+    /// в stdout.
+    /// </summary>
+    /// <param name="name">Имя ресурса с описанием сцены.</param>
+    /// <returns>false, если файл не найден или содержит ошибку.</returns>
+    bool load(const char* name, GLFWwindow* window, TextureManager& textures, MeshImporter& importer, JobSystem& jobs);
+
+    /// <summary>
+    /// Изменение локального преобразования объекта (относительно родителя).
+    /// Пересчёт откладывается до update_transforms().
+    /// </summary>
+    void set_position(size_t i, glm::vec3 p) { transforms.set_position((int)i, p); }
+    void set_rotation(size_t i, glm::vec3 r) { transforms.set_rotation((int)i, r); }
+    void set_scale(size_t i, glm::vec3 s) { transforms.set_scale((int)i, s); }
+
+    /// <summary>
+    /// Пересчёт мировых матриц и границ изменённых объектов и их потомков
+    /// и перенос сдвинувшихся объектов в дереве AABB. Если ничего не
+    /// менялось, работы нет.
+    /// </summary>
+    void update_transforms();
+
+    /// <summary>
+    /// Мировая матрица объекта на момент последнего update_transforms().
+    /// </summary>
+    const glm::mat4& world_matrix(size_t i) const { return transforms.world((int)i); }
+    glm::vec3 world_position(size_t i) const { return glm::vec3(transforms.world((int)i)[3]); }
+
+    /// <summary>
+    /// Начало шага симуляции: текущие мировые матрицы становятся
+    /// предыдущими для render_matrix().
+    /// </summary>
+    void begin_tick() { update_transforms(); transforms.save_previous(); ropes.save_previous(); }
+
+    /// <summary>
+    /// Шаг симуляции верёвок (около 1 кГц внутри тика): концы переносятся
+    /// за объектами-опорами, границы кабелей обновляются для отсечения.
+    /// Вызывается после update_transforms().
+    /// </summary>
+    void simulate(float dt);
+
+    /// <summary>
+    /// Вершины кабелей по частицам на момент alpha между тиками (кабели
+    /// строятся параллельно в пуле задач; при тесселяции - только сами
+    /// частицы). GL не вызывается, буфер verts принадлежит кадру.
+    /// </summary>
+    /// <param name="verts">Вершины, по массиву на кабель.</param>
+    void build_ropes(float alpha, vector<vector<glm::vec3>>& verts);
+
+    /// <summary>
+    /// Отправка вершин из build_ropes() в модели кабелей. Вызывается в
+    /// потоке с GL контекстом.
+    /// </summary>
+    void stream_ropes(const vector<vector<glm::vec3>>& verts);
+
+    /// <summary>
+    /// Мировая матрица для кадра, лежащего между двумя шагами симуляции.
+    /// </summary>
+    /// <param name="alpha">Доля шага, прошедшая после последнего тика (0..1).</param>
+    glm::mat4 render_matrix(size_t i, float alpha) const { return transforms.interpolated((int)i, alpha); }
+
+    /// <summary>
+    /// Индексы объектов, попадающих в пирамиду видимости, по возрастанию.
+    /// Части дерева обходятся параллельно в jobs.
+    /// </summary>
+    void cull(const glm::mat4& view_proj, vector<int>& visible, JobSystem& jobs);
+
+    /// <summary>
+    /// Ближайший объект, чей мировой AABB пересекает луч origin + dir * t
+    /// (0 &lt;= t &lt;= max_t).
+    /// </summary>
+    /// <param name="t_hit">Параметр точки входа луча в AABB объекта.</param>
+    /// <returns>Индекс объекта или -1.</returns>
+    int ray_cast(const glm::vec3& origin, const glm::vec3& dir, float max_t, float* t_hit) const;
+
+    /// <summary>
+    /// Ближайший объект, чьи треугольники пересекает луч: отбор по дереву
+    /// и мировым AABB, затем треугольники в локальных координатах объекта.
+    /// Объекты без треугольников на CPU (кабели) лучом не выбираются.
+    /// </summary>
+    /// <param name="t_hit">Параметр точки попадания в треугольник.</param>
+    /// <returns>Индекс объекта или -1.</returns>
+    int pick(const glm::vec3& origin, const glm::vec3& dir, float max_t, float* t_hit) const;
+
+    /// <summary>
+    /// Объект, который перетаскивается при выборе объекта i: он сам или
+    /// ближайший предок с флагом draggable, -1 - если такого нет.
+    /// </summary>
+    int drag_handle(size_t i) const;
+
+    /// <summary>
+    /// Сдвиг объекта на delta в мировых осях (у его родителя не должно
+    /// быть поворота и масштаба) с ограничением по carry.
+    /// </summary>
+    void drag(size_t i, glm::vec3 delta);
+
+    /// <summary>
+    /// Объекты, чьи мировые AABB пересекают box.
+    /// </summary>
+    void overlap(const Aabb& box, vector<int>& found) const;
+
+    /// <summary>
+    /// Сдвиг управляемых объектов с ограничением по carry.
+    /// </summary>
+    void move_controlled(glm::vec3 delta);
+
+    vector<SceneObject> objects;
+    TransformStore transforms;
+    AabbTree tree;          // мировые AABB объектов (user - индекс объекта)
+    RopeSystem ropes;
+    glm::vec3 camera_position = glm::vec3(0.0f);
+    float camera_yaw = 0.0f;
+    float camera_pitch = 0.0f;
+private:
+    void queue_import(size_t i, const ObjectDesc& d, MeshImporter& importer, TextureManager& textures);
+    void set_bounds(size_t i, const glm::vec3& lo, const glm::vec3& hi);
+    void keep_carried(size_t i);
+
+    // кабель-верёвка: объект сцены и опоры её концов
+    struct RopeLink {
+        int object;
+        RopeSystem::RopeId rope;
+        int anchor[2];
+        glm::vec3 offset[2];  // от опоры до конца верёвки, в мировых осях
+        bool patches;         // модель из опорных точек (SHADER_TESSELLATED)
+        int radial;           // секторов трубки, 0 - лента
+        float radius;         // радиус трубки или полширины ленты
+        vector<glm::vec3> axis;
+        TubeSweep tube;
+    };
+    vector<int> proxies;    // лист объекта в tree, -1 - границ ещё нет
+    vector<int> unbounded;  // объекты без границ: видны всегда
+    vector<int> moved;
+    vector<int> subtrees;           // для параллельного cull
+    vector<vector<int>> subtree_visible;
+
+    vector<RopeLink> rope_links;
+    JobSystem* jobs = nullptr;
+};
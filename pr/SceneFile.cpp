@@ -0,0 +1,263 @@
+﻿// SceneFile.cpp
+#include "SceneFile.h"
+#include "Shader.h"
+#include "Texture.h"
+#include <cstring>
+
+namespace {
+    struct Token {
+        const char* p = nullptr;
+        size_t n = 0;
+
+        bool is(const char* s) const { return strlen(s) == n && memcmp(p, s, n) == 0; }
+        string str() const { return string(p, n); }
+    };
+
+    // Лексер по строкам: next() отдаёт слова текущей строки, пустой токен -
+    // конец строки; next_line() переходит к следующей непустой строке.
+    class Lexer {
+    public:
+        Lexer(const char* text, size_t size) : at(text), end(text + size) {}
+
+        bool next_line() {
+            while (at < end) {
+                skip_blank();
+                if (at < end && *at == '\n') {
+                    at++;
+                    line++;
+                    continue;
+                }
+                return at < end;
+            }
+            return false;
+        }
+
+        Token next() {
+            skip_blank();
+            Token t;
+            if (at >= end || *at == '\n') return t;
+            t.p = at;
+            while (at < end && !is_space(*at) && *at != '#') at++;
+            t.n = at - t.p;
+            return t;
+        }
+
+        bool at_line_end() {
+            skip_blank();
+            return at >= end || *at == '\n';
+        }
+
+        int line = 1;
+    private:
+        static bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+        void skip_blank() {
+            while (at < end && (*at == ' ' || *at == '\t' || *at == '\r')) at++;
+            if (at < end && *at == '#')
+                while (at < end && *at != '\n') at++;
+        }
+
+        const char* at;
+        const char* end;
+    };
+
+    // Разбор числа без strtod: текст не обязан заканчиваться нулём.
+    bool parse_float(const Token& t, float& out) {
+        const char* p = t.p;
+        const char* e = t.p + t.n;
+        if (p == e) return false;
+        bool neg = false;
+        if (*p == '-' || *p == '+') neg = *p++ == '-';
+        double v = 0.0;
+        int digits = 0;
+        while (p < e && *p >= '0' && *p <= '9') {
+            v = v * 10.0 + (*p++ - '0');
+            digits++;
+        }
+        if (p < e && *p == '.') {
+            p++;
+            double scale = 0.1;
+            while (p < e && *p >= '0' && *p <= '9') {
+                v += (*p++ - '0') * scale;
+                scale *= 0.1;
+                digits++;
+            }
+        }
+        if (!digits) return false;
+        if (p < e && (*p == 'e' || *p == 'E')) {
+            p++;
+            bool eneg = false;
+            if (p < e && (*p == '-' || *p == '+')) eneg = *p++ == '-';
+            int ex = 0;
+            if (p == e) return false;
+            while (p < e && *p >= '0' && *p <= '9') ex = ex * 10 + (*p++ - '0');
+            double m = 1.0;
+            for (int i = 0; i < ex; i++) m *= 10.0;
+            v = eneg ? v / m : v * m;
+        }
+        if (p != e) return false;
+        out = (float)(neg ? -v : v);
+        return true;
+    }
+
+    class Parser {
+    public:
+        Parser(const char* text, size_t size, SceneDesc& out) : lex(text, size), scene(out) {}
+
+        bool run(string& error) {
+            while (lex.next_line()) {
+                Token word = lex.next();
+                if (!statement(word)) {
+                    error = "line " + to_string(lex.line) + ": " + message;
+                    return false;
+                }
+                if (!lex.at_line_end()) {
+                    error = "line " + to_string(lex.line) + ": unexpected '" + lex.next().str() + "'";
+                    return false;
+                }
+            }
+            return true;
+        }
+    private:
+        bool fail(const string& m) {
+            message = m;
+            return false;
+        }
+
+        bool number(float& v) {
+            Token t = lex.next();
+            return parse_float(t, v) || fail("number expected");
+        }
+
+        bool vec3(glm::vec3& v) {
+            return number(v.x) && number(v.y) && number(v.z);
+        }
+
+        bool name(string& out) {
+            Token t = lex.next();
+            if (!t.n) return fail("name expected");
+            out = t.str();
+            return true;
+        }
+
+        ObjectDesc* current() {
+            return scene.objects.empty() ? nullptr : &scene.objects.back();
+        }
+
+        bool statement(const Token& word) {
+            if (word.is("camera")) return camera();
+            if (word.is("object")) {
+                scene.objects.push_back(ObjectDesc());
+                scene.objects.back().line = lex.line;
+                return name(scene.objects.back().name);
+            }
+
+            ObjectDesc* obj = current();
+            if (!obj) return fail("'" + word.str() + "' outside of object");
+            if (word.is("mesh")) return mesh(obj->mesh);
+            if (word.is("model")) return name(obj->model);
+            if (word.is("position")) return vec3(obj->position);
+            if (word.is("rotation")) return vec3(obj->rotation);
+            if (word.is("scale")) return vec3(obj->scale);
+            if (word.is("shader")) return shader(*obj);
+            if (word.is("texture")) return texture(*obj);
+            if (word.is("parent")) return name(obj->parent);
+            if (word.is("carry")) return name(obj->carry);
+            if (word.is("rope")) return name(obj->rope_start) && name(obj->rope_end);
+            if (word.is("controlled")) {
+                obj->controlled = true;
+                return true;
+            }
+            if (word.is("draggable")) {
+                obj->draggable = true;
+                return true;
+            }
+            return fail("unknown statement '" + word.str() + "'");
+        }
+
+        bool camera() {
+            for (Token t = lex.next(); t.n; t = lex.next()) {
+                bool ok;
+                if (t.is("position")) ok = vec3(scene.camera_position);
+                else if (t.is("yaw")) ok = number(scene.camera_yaw);
+                else if (t.is("pitch")) ok = number(scene.camera_pitch);
+                else return fail("unknown camera parameter '" + t.str() + "'");
+                if (!ok) return false;
+            }
+            return true;
+        }
+
+        bool mesh(MeshDesc& m) {
+            Token kind = lex.next();
+            if (kind.is("box")) m.generator = MESH_BOX;
+            else if (kind.is("textured_box")) m.generator = MESH_TEXTURED_BOX;
+            else if (kind.is("room")) m.generator = MESH_ROOM;
+            else if (kind.is("cable")) m.generator = MESH_CABLE;
+            else return fail("unknown mesh generator '" + kind.str() + "'");
+
+            for (Token t = lex.next(); t.n; t = lex.next()) {
+                bool ok;
+                if (t.is("size")) ok = vec3(m.size);
+                else if (t.is("color")) ok = vec3(m.color);
+                else if (t.is("p0")) ok = vec3(m.p0);
+                else if (t.is("p1")) ok = vec3(m.p1);
+                else if (t.is("p2")) ok = vec3(m.p2);
+                else if (t.is("segments")) {
+                    float s;
+                    ok = number(s);
+                    m.segments = (int)s;
+                    if (ok && m.segments < 1) return fail("segments must be positive");
+                }
+                else if (t.is("radius")) ok = number(m.radius);
+                else if (t.is("radial")) {
+                    float r;
+                    ok = number(r);
+                    m.radial = (int)r;
+                    if (ok && m.radial < 3) return fail("radial must be at least 3");
+                }
+                else return fail("unknown mesh parameter '" + t.str() + "'");
+                if (!ok) return false;
+            }
+            return true;
+        }
+
+        bool shader(ObjectDesc& obj) {
+            obj.features = 0;
+            for (Token t = lex.next(); t.n; t = lex.next()) {
+                if (t.is("vertex_color")) obj.features |= SHADER_VERTEX_COLOR;
+                else if (t.is("textured")) obj.features |= SHADER_TEXTURED;
+                else if (t.is("stripes")) obj.features |= SHADER_STRIPES;
+                else if (t.is("tessellated")) obj.features |= SHADER_TESSELLATED;
+                else return fail("unknown shader feature '" + t.str() + "'");
+            }
+            return true;
+        }
+
+        bool texture(ObjectDesc& obj) {
+            if (!name(obj.texture)) return false;
+            Token t = lex.next();
+            if (!t.n) return true;
+            if (t.is("trilinear")) obj.sampler = SAMPLER_TRILINEAR;
+            else if (t.is("anisotropic")) obj.sampler = SAMPLER_ANISOTROPIC;
+            else if (t.is("clamp")) obj.sampler = SAMPLER_CLAMP;
+            else if (t.is("nearest")) obj.sampler = SAMPLER_NEAREST;
+            else return fail("unknown sampler '" + t.str() + "'");
+            return true;
+        }
+
+        Lexer lex;
+        SceneDesc& scene;
+        string message;
+    };
+}
+
+bool ParseScene(const char* text, size_t size, SceneDesc& out, string& error) {
+    out = SceneDesc();
+    error.clear();
+    if (size >= 3 && memcmp(text, "\xEF\xBB\xBF", 3) == 0) { // BOM от редакторов Windows
+        text += 3;
+        size -= 3;
+    }
+    Parser parser(text, size, out);
+    return parser.run(error);
+}
@@ -0,0 +1,82 @@
+﻿#pragma once
+#include "Shader.h"
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Текстовое описание сцены (см. scene.txt). Одна инструкция на строку,
+// "#" - комментарий до конца строки:
+//   camera position x y z yaw a pitch b
+//   object <имя>                      - начало объекта, дальше его свойства
+//     mesh box size x y z color r g b
+//     mesh textured_box size x y z
+//     mesh room
+//     mesh cable p0 x y z p1 x y z p2 x y z segments n color r g b
+//                [radius r radial n]  - круглая трубка из n секторов
+//                                       вместо плоской ленты
+//     model <имя>                     - models/<имя>.mesh или .obj, заменяет mesh
+//     position x y z | rotation x y z | scale x y z
+//     shader vertex_color textured stripes tessellated
+//                                     - tessellated: кабель строится на GPU
+//                                       из опорных точек (см. tess.glsl),
+//                                       radial при этом не действует
+//     texture <ресурс> [trilinear|anisotropic|clamp|nearest]
+//     parent <объект>                 - преобразование задано относительно
+//                                       родителя (он должен быть выше по файлу)
+//     controlled                      - двигается клавишами IJKL
+//     draggable                       - перетаскивается мышью (вместе с
+//                                       дочерними объектами)
+//     carry <объект>                  - объект не должен съехать с этого
+//     rope <объект> <объект>          - кабель (mesh cable, мировые
+//                                       координаты) моделируется верёвкой,
+//                                       концы следуют за объектами
+
+enum MeshGenerator { MESH_NONE, MESH_BOX, MESH_TEXTURED_BOX, MESH_ROOM, MESH_CABLE };
+
+/// <summary>
+/// Параметры генератора сетки (используются те, что нужны генератору).
+/// </summary>
+struct MeshDesc {
+    MeshGenerator generator = MESH_NONE;
+    glm::vec3 size = glm::vec3(1.0f);
+    glm::vec3 color = glm::vec3(1.0f);
+    glm::vec3 p0 = glm::vec3(0.0f), p1 = glm::vec3(0.0f), p2 = glm::vec3(0.0f);
+    int segments = 32;
+    float radius = 0.015f;
+    int radial = 0;                       // 0 - плоская лента
+};
+
+struct ObjectDesc {
+    string name;
+    MeshDesc mesh;
+    string model;
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 rotation = glm::vec3(0.0f); // градусы, порядок Y-X-Z
+    glm::vec3 scale = glm::vec3(1.0f);
+    unsigned features = SHADER_VERTEX_COLOR;
+    string texture;
+    int sampler = 0;                      // SamplerKind
+    string parent;
+    string carry;
+    string rope_start, rope_end;
+    bool controlled = false;
+    bool draggable = false;
+    int line = 0;
+};
+
+struct SceneDesc {
+    glm::vec3 camera_position = glm::vec3(0.0f);
+    float camera_yaw = 0.0f;
+    float camera_pitch = 0.0f;
+    vector<ObjectDesc> objects;
+};
+
+/// <summary>
+/// Разбор описания сцены за один проход по тексту, без копирования строк
+/// и без потоков ввода.
+/// </summary>
+/// <param name="error">Сообщение с номером строки при ошибке.</param>
+/// <returns>false, если описание содержит ошибку.</returns>
+bool ParseScene(const char* text, size_t size, SceneDesc& out, string& error);
@@ -0,0 +1,172 @@
+﻿// Shader.cpp
+#include "Shader.h"
+#include "func.h"
+
+namespace {
+    struct FeatureDefine {
+        unsigned bit;
+        const char* name;
+    };
+
+    const FeatureDefine feature_defines[] = {
+        { SHADER_VERTEX_COLOR, "VERTEX_COLOR" },
+        { SHADER_TEXTURED, "TEXTURED" },
+        { SHADER_STRIPES, "STRIPES" },
+        { SHADER_TESSELLATED, "TESSELLATED" },
+    };
+
+    const char* stage_define(GLenum stage) {
+        switch (stage) {
+        case GL_VERTEX_SHADER: return "#define VERTEX_SHADER\n";
+        case GL_TESS_CONTROL_SHADER: return "#define TESS_CONTROL_SHADER\n";
+        case GL_TESS_EVALUATION_SHADER: return "#define TESS_EVALUATION_SHADER\n";
+        default: return "#define FRAGMENT_SHADER\n";
+        }
+    }
+
+    string directory_of(const string& path) {
+        size_t p = path.find_last_of("/\\");
+        return p == string::npos ? string() : path.substr(0, p + 1);
+    }
+
+    // Разбор строки вида `#include "file"`; возвращает false, если это не #include.
+    bool parse_include(const string& line, string& name) {
+        size_t i = line.find_first_not_of(" \t");
+        if (i == string::npos || line.compare(i, 8, "#include") != 0) return false;
+        size_t open = line.find('"', i + 8);
+        size_t close = open == string::npos ? open : line.find('"', open + 1);
+        if (close == string::npos) return false;
+        name = line.substr(open + 1, close - open - 1);
+        return true;
+    }
+}
+
+GLuint compile_shader(const char* src, GLenum type) {
+    GLuint s = glCreateShader(type);
+    glShaderSource(s, 1, &src, nullptr);
+    glCompileShader(s);
+    GLint ok;
+    glGetShaderiv(s, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        GLint len;
+        glGetShaderiv(s, GL_INFO_LOG_LENGTH, &len);
+        std::string log(len, ' ');
+        glGetShaderInfoLog(s, len, nullptr, &log[0]);
+        std::cerr << "Shader compile error: " << log << std::endl;
+    }
+    return s;
+}
+
+ShaderCache& ShaderCache::instance() {
+    static ShaderCache cache;
+    return cache;
+}
+
+const string& ShaderCache::source(const string& filename) {
+    auto it = sources.find(filename);
+    if (it == sources.end())
+        it = sources.emplace(filename, LoadShader(filename.c_str())).first;
+    return it->second;
+}
+
+int ShaderCache::file_index(const string& filename) {
+    for (size_t i = 0; i < files.size(); i++)
+        if (files[i] == filename) return (int)i;
+    files.push_back(filename);
+    return (int)files.size() - 1;
+}
+
+void ShaderCache::expand(const string& filename, string& out, vector<string>& stack) {
+    if (std::find(stack.begin(), stack.end(), filename) != stack.end()) {
+        std::cerr << "Recursive #include of " << filename << std::endl;
+        return;
+    }
+    stack.push_back(filename);
+    int index = file_index(filename);
+    out += "#line 1 " + to_string(index) + "\n";
+
+    std::istringstream in(source(filename));
+    string line, inc;
+    int line_no = 0;
+    while (std::getline(in, line)) {
+        line_no++;
+        // #version уже выведен первой строкой результата
+        if (line.compare(0, 8, "#version") == 0) {
+            out += "\n";
+            continue;
+        }
+        if (parse_include(line, inc)) {
+            expand(directory_of(filename) + inc, out, stack);
+            out += "#line " + to_string(line_no + 1) + " " + to_string(index) + "\n";
+            continue;
+        }
+        out += line;
+        out += "\n";
+    }
+    stack.pop_back();
+}
+
+string ShaderCache::preprocess(const char* filename, GLenum stage, unsigned features) {
+    const string& src = source(filename);
+    string version = "#version 400";
+    size_t v = src.find("#version");
+    if (v != string::npos) version = src.substr(v, src.find('\n', v) - v);
+
+    string out = version + "\n";
+    out += stage_define(stage);
+    for (const FeatureDefine& f : feature_defines)
+        if (features & f.bit) out += string("#define ") + f.name + "\n";
+
+    vector<string> stack;
+    expand(filename, out, stack);
+    return out;
+}
+
+GLuint ShaderCache::get(const char* vect, const char* frag, unsigned features, const char* tess) {
+    bool tessellated = (features & SHADER_TESSELLATED) != 0;
+    string key = string(vect) + "|" + frag + "|" + to_string(features);
+    if (tessellated) key += string("|") + tess;
+    auto it = programs.find(key);
+    if (it != programs.end()) return it->second;
+    if (source(vect).empty() || source(frag).empty() || (tessellated && source(tess).empty())) {
+        std::cerr << "Missing shader source for " << key << std::endl;
+        return 0;
+    }
+
+    // один файл тесселяции собирается дважды, со своим #define для каждой стадии
+    vector<GLuint> shaders;
+    shaders.push_back(compile_shader(preprocess(vect, GL_VERTEX_SHADER, features).c_str(), GL_VERTEX_SHADER));
+    if (tessellated) {
+        shaders.push_back(compile_shader(preprocess(tess, GL_TESS_CONTROL_SHADER, features).c_str(), GL_TESS_CONTROL_SHADER));
+        shaders.push_back(compile_shader(preprocess(tess, GL_TESS_EVALUATION_SHADER, features).c_str(), GL_TESS_EVALUATION_SHADER));
+    }
+    shaders.push_back(compile_shader(preprocess(frag, GL_FRAGMENT_SHADER, features).c_str(), GL_FRAGMENT_SHADER));
+
+    GLuint prog = glCreateProgram();
+    for (GLuint sh : shaders) glAttachShader(prog, sh);
+    glLinkProgram(prog);
+
+    GLint ok;
+    glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        GLint len;
+        glGetProgramiv(prog, GL_INFO_LOG_LENGTH, &len);
+        std::string log(len, ' ');
+        glGetProgramInfoLog(prog, len, nullptr, &log[0]);
+        std::cerr << "Program link error (" << key << "): " << log << std::endl;
+        // номера файлов из #line в логе компилятора
+        for (size_t i = 0; i < files.size(); i++)
+            std::cerr << "  " << i << ": " << files[i] << std::endl;
+    }
+
+    for (GLuint sh : shaders) glDeleteShader(sh);
+
+    programs[key] = prog;
+    return prog;
+}
+
+void ShaderCache::clear() {
+    for (auto& p : programs) glDeleteProgram(p.second);
+    programs.clear();
+    sources.clear();
+}
@@ -0,0 +1,68 @@
+﻿#pragma once
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+#include <map>
+
+using namespace std;
+
+/// <summary>
+/// Флаги возможностей шейдера. Каждая комбинация флагов даёт отдельную
+/// перестановку (permutation) с набором #define в исходнике.
+/// </summary>
+enum ShaderFeature : unsigned {
+    SHADER_VERTEX_COLOR = 1u << 0, // цвет берётся из атрибута вершины
+    SHADER_TEXTURED = 1u << 1,     // умножение на текстуру tex по uv
+    SHADER_STRIPES = 1u << 2,      // анимированные полосы по u_time
+    SHADER_TESSELLATED = 1u << 3,  // вершины - опорные точки кабеля, лента
+                                   // строится стадиями тесселяции (патчи по 4)
+};
+
+/// <summary>
+/// Компиляция одного шейдерного объекта.
+/// </summary>
+/// <param name="src">Исходный код.</param>
+/// <param name="type">Тип шейдера (GL_VERTEX_SHADER и т.д.).</param>
+/// <returns>ID шейдера.</returns>
+GLuint compile_shader(const char* src, GLenum type);
+
+/// <summary>
+/// Кэш шейдерных программ. Разворачивает #include, подставляет #define
+/// для выбранных возможностей и хранит уже собранные перестановки, чтобы
+/// одинаковые сочетания файлов и флагов компилировались один раз.
+/// </summary>
+class ShaderCache
+{
+public:
+    static ShaderCache& instance();
+
+    /// <summary>
+    /// Получение программы для пары файлов и набора флагов.
+    /// </summary>
+    /// <param name="vect">Файл вершинного шейдера.</param>
+    /// <param name="frag">Файл фрагментного шейдера.</param>
+    /// <param name="features">Маска ShaderFeature.</param>
+    /// <param name="tess">Файл стадий тесселяции (для SHADER_TESSELLATED).</param>
+    /// <returns>ID программы (0 при ошибке).</returns>
+    GLuint get(const char* vect, const char* frag, unsigned features, const char* tess = "tess.glsl");
+
+    /// <summary>
+    /// Исходник после препроцессора: #version, затем #define флагов и
+    /// стадии, затем текст с развёрнутыми #include.
+    /// </summary>
+    string preprocess(const char* filename, GLenum stage, unsigned features);
+
+    /// <summary>
+    /// Удаление всех программ (до glfwTerminate).
+    /// </summary>
+    void clear();
+private:
+    ShaderCache() {}
+    void expand(const string& filename, string& out, vector<string>& stack);
+    const string& source(const string& filename);
+    int file_index(const string& filename);
+
+    map<string, GLuint> programs;
+    map<string, string> sources;
+    vector<string> files; // номер файла в #line -> имя файла
+};
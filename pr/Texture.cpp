@@ -0,0 +1,430 @@
+﻿// Texture.cpp
+#include "Texture.h"
+#include "Assets.h"
+#include <GLFW/glfw3.h>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+#include "stb-master/stb_image.h"
+
+namespace {
+    int mip_levels(int w, int h) {
+        int levels = 1;
+        while (w > 1 || h > 1) {
+            w = std::max(1, w / 2);
+            h = std::max(1, h / 2);
+            levels++;
+        }
+        return levels;
+    }
+}
+
+SamplerCache& SamplerCache::instance() {
+    static SamplerCache cache;
+    return cache;
+}
+
+GLuint SamplerCache::get(SamplerKind kind) {
+    GLuint& s = samplers[kind];
+    if (s) return s;
+
+    glGenSamplers(1, &s);
+    GLenum wrap = kind == SAMPLER_CLAMP ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+    glSamplerParameteri(s, GL_TEXTURE_WRAP_S, wrap);
+    glSamplerParameteri(s, GL_TEXTURE_WRAP_T, wrap);
+    if (kind == SAMPLER_NEAREST) {
+        glSamplerParameteri(s, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glSamplerParameteri(s, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    else {
+        glSamplerParameteri(s, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glSamplerParameteri(s, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    if (kind == SAMPLER_ANISOTROPIC && GLEW_EXT_texture_filter_anisotropic) {
+        GLfloat max_aniso = 1.0f;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_aniso);
+        glSamplerParameterf(s, GL_TEXTURE_MAX_ANISOTROPY_EXT, std::min(max_aniso, 16.0f));
+    }
+    return s;
+}
+
+void SamplerCache::clear() {
+    for (GLuint& s : samplers) {
+        if (s) glDeleteSamplers(1, &s);
+        s = 0;
+    }
+}
+
+void bind_texture(GLuint unit, const Texture& tex, SamplerKind sampler) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    const Texture& image = tex.image();
+    glBindTexture(GL_TEXTURE_2D, image.id);
+    glBindSampler(unit, SamplerCache::instance().get(image.resident ? sampler : SAMPLER_NEAREST));
+}
+
+TextureManager::TextureManager(size_t pbo_size) {
+    has_storage = GLEW_ARB_texture_storage || GLEW_VERSION_4_2;
+
+    // 2x2 шахматка: видно, что текстура ещё грузится
+    const unsigned char checker[] = {
+        200, 200, 200, 255,  120, 120, 120, 255,
+        120, 120, 120, 255,  200, 200, 200, 255,
+    };
+    glGenTextures(1, &placeholder_id);
+    allocate(placeholder_id, GL_RGBA8, 2, 2, 1, false);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 2, 2, GL_RGBA, GL_UNSIGNED_BYTE, checker);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    has_s3tc = GLEW_EXT_texture_compression_s3tc != 0;
+    has_bptc = GLEW_ARB_texture_compression_bptc || GLEW_VERSION_4_2;
+
+    slot_size = pbo_size;
+    glGenBuffers(1, &pbo);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    if (GLEW_ARB_buffer_storage) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, slot_size * pbo_slots, nullptr, flags);
+        mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, slot_size * pbo_slots, flags);
+    }
+    else {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, slot_size * pbo_slots, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    graveyard = make_shared<Graveyard>();
+    worker = thread(&TextureManager::worker_main, this);
+}
+
+TextureManager::~TextureManager() {
+    {
+        lock_guard<mutex> g(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+shared_ptr<Texture> TextureManager::load(const char* name) {
+    auto found = by_path.find(name);
+    if (found != by_path.end())
+        if (shared_ptr<Texture> tex = found->second.lock()) return tex;
+
+    shared_ptr<Graveyard> grave = graveyard;
+    shared_ptr<Texture> tex(new Texture(), [grave](Texture* t) {
+        if (t->resident) {
+            lock_guard<mutex> g(grave->lock);
+            if (!grave->closed) grave->ids.push_back(t->id);
+        }
+        delete t;
+    });
+    tex->name = name;
+    tex->id = placeholder_id;
+    by_path[name] = tex;
+
+    pending++;
+    {
+        lock_guard<mutex> g(lock);
+        decode_queue.push_back({ tex });
+    }
+    wake.notify_one();
+    return tex;
+}
+
+void TextureManager::collect() {
+    vector<GLuint> ids;
+    {
+        lock_guard<mutex> g(graveyard->lock);
+        ids.swap(graveyard->ids);
+    }
+    if (ids.empty()) return;
+    glDeleteTextures((GLsizei)ids.size(), ids.data());
+
+    for (auto it = by_path.begin(); it != by_path.end();)
+        it = it->second.expired() ? by_path.erase(it) : std::next(it);
+}
+
+bool TextureManager::supported(uint32_t format) const {
+    if (format == CTEX_BC1 || format == CTEX_BC3) return has_s3tc;
+    if (format == CTEX_BC7) return has_bptc;
+    return false;
+}
+
+bool TextureManager::load_baked(Job& job) {
+    const string& name = job.tex->name;
+    size_t dot = name.rfind('.');
+    if (dot == string::npos || name.compare(dot, string::npos, ".png") != 0) return false;
+    string baked = name.substr(0, dot) + ".ctex";
+    if (!AssetExists(baked.c_str())) return false;
+
+    job.blob = LoadAsset(baked.c_str());
+    if (!job.blob || !ParseCtex(job.blob.data, job.blob.size, job.image)) {
+        std::cerr << "Broken baked texture " << baked << ", falling back to " << name << std::endl;
+        job.blob = AssetBlob();
+        return false;
+    }
+    if (!supported(job.image.format)) {
+        job.blob = AssetBlob();
+        return false;
+    }
+    job.compressed = true;
+    job.width = job.image.width;
+    job.height = job.image.height;
+    return true;
+}
+
+void TextureManager::worker_main() {
+    for (;;) {
+        Request req;
+        {
+            unique_lock<mutex> g(lock);
+            wake.wait(g, [this] { return stopping || !decode_queue.empty(); });
+            if (stopping) return;
+            req = std::move(decode_queue.front());
+            decode_queue.pop_front();
+        }
+
+        shared_ptr<Texture>& tex = req.tex;
+        Job job;
+        job.tex = tex;
+        AssetBlob blob = LoadAsset(tex->name.c_str());
+        if (blob) {
+            job.hash = HashBytes(blob.data, blob.size);
+            auto same = by_hash.find(job.hash);
+            if (same != by_hash.end()) job.same = same->second.lock();
+            if (job.same) {
+                lock_guard<mutex> g(lock);
+                ready.push_back(std::move(job));
+                continue;
+            }
+            by_hash[job.hash] = tex;
+        }
+
+        if (load_baked(job)) {
+            lock_guard<mutex> g(lock);
+            ready.push_back(std::move(job));
+            continue;
+        }
+
+        int channels;
+        unsigned char* data = blob ? stbi_load_from_memory(blob.data, (int)blob.size, &job.width, &job.height, &channels, 4) : nullptr;
+        if (data) {
+            job.pixels.assign(data, data + (size_t)job.width * job.height * 4);
+            stbi_image_free(data);
+        }
+        else {
+            std::cerr << "Failed to load texture " << tex->name << std::endl;
+        }
+
+        lock_guard<mutex> g(lock);
+        ready.push_back(std::move(job));
+    }
+}
+
+// Выделение памяти под все уровни сразу. Неизменяемое хранилище не нужно
+// перепроверять на полноту при каждой отрисовке; без него уровни задаются
+// по одному, а GL_TEXTURE_MAX_LEVEL ограничивает цепочку.
+void TextureManager::allocate(GLuint id, GLenum format, int width, int height, int levels, bool compressed) {
+    glBindTexture(GL_TEXTURE_2D, id);
+    if (has_storage) {
+        glTexStorage2D(GL_TEXTURE_2D, levels, format, width, height);
+        return;
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    if (compressed) return; // уровни задаст glCompressedTexImage2D при загрузке
+    for (int i = 0; i < levels; i++) {
+        glTexImage2D(GL_TEXTURE_2D, i, format, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+}
+
+bool TextureManager::stage(const unsigned char* src, size_t bytes, size_t& offset) {
+    GLsync& fence = fences[slot];
+    if (fence) {
+        // GPU ещё читает этот участок PBO - продолжим в следующем кадре
+        if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) return false;
+        glDeleteSync(fence);
+        fence = 0;
+    }
+
+    offset = slot_size * slot;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    if (mapped) {
+        memcpy(mapped + offset, src, bytes);
+    }
+    else {
+        void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, offset, bytes,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (dst) {
+            memcpy(dst, src, bytes);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        else {
+            // отображение не удалось (нехватка памяти, сбой драйвера) -
+            // копирование силами GL; участок свободен, fence уже прошёл
+            glBufferSubData(GL_PIXEL_UNPACK_BUFFER, offset, bytes, src);
+        }
+    }
+    return true;
+}
+
+void TextureManager::release_slot() {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot = (slot + 1) % pbo_slots;
+}
+
+bool TextureManager::upload_chunk(Job& job) {
+    size_t row_bytes = (size_t)job.width * 4;
+    glBindTexture(GL_TEXTURE_2D, job.id);
+    if (row_bytes > slot_size) {
+        // строка не помещается в участок PBO - грузим напрямую из памяти
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, job.rows_done, job.width, job.height - job.rows_done,
+            GL_RGBA, GL_UNSIGNED_BYTE, job.pixels.data() + row_bytes * job.rows_done);
+        job.rows_done = job.height;
+        return true;
+    }
+
+    int rows = (int)std::min<size_t>(slot_size / row_bytes, job.height - job.rows_done);
+    size_t offset;
+    if (!stage(job.pixels.data() + row_bytes * job.rows_done, row_bytes * rows, offset)) return false;
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, job.rows_done, job.width, rows, GL_RGBA, GL_UNSIGNED_BYTE, (void*)offset);
+    release_slot();
+    job.rows_done += rows;
+    return true;
+}
+
+bool TextureManager::upload_level(Job& job) {
+    const CtexLevel& level = job.image.levels[job.levels_done];
+    const void* src = level.data;
+    size_t offset = 0;
+    bool staged = level.size <= slot_size;
+    if (staged) {
+        if (!stage(level.data, level.size, offset)) return false;
+        src = (const void*)offset;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, job.id);
+    if (has_storage)
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, job.levels_done, 0, 0, level.width, level.height,
+            job.image.format, (GLsizei)level.size, src);
+    else
+        glCompressedTexImage2D(GL_TEXTURE_2D, job.levels_done, job.image.format, level.width, level.height, 0,
+            (GLsizei)level.size, src);
+
+    if (staged) release_slot();
+    job.levels_done++;
+    return true;
+}
+
+void TextureManager::update(double budget_ms) {
+    collect();
+    double start = glfwGetTime();
+    while ((glfwGetTime() - start) * 1000.0 < budget_ms) {
+        if (!has_current) {
+            lock_guard<mutex> g(lock);
+            if (ready.empty()) break;
+            current = std::move(ready.front());
+            ready.pop_front();
+            has_current = true;
+        }
+        if (current.same) {
+            // update() идёт, пока кадр не готовится, так что подготовка
+            // кадра не увидит same наполовину записанным
+            current.tex->same = current.same;
+            current.tex->hash = current.hash;
+            current = Job();
+            has_current = false;
+            pending--;
+            continue;
+        }
+        if (current.compressed) {
+            if (!current.id) {
+                glGenTextures(1, &current.id);
+                allocate(current.id, current.image.format, current.width, current.height,
+                    (int)current.image.levels.size(), true);
+            }
+            if (!upload_level(current)) break;
+            if (current.levels_done == (int)current.image.levels.size()) finish(current);
+            continue;
+        }
+        if (current.pixels.empty()) {
+            // декодирование не удалось - оставляем заглушку
+            has_current = false;
+            pending--;
+            continue;
+        }
+
+        if (!current.id) {
+            glGenTextures(1, &current.id);
+            allocate(current.id, GL_RGBA8, current.width, current.height, mip_levels(current.width, current.height), false);
+        }
+
+        if (!upload_chunk(current)) break;
+
+        if (current.rows_done == current.height) {
+            glGenerateMipmap(GL_TEXTURE_2D);
+            finish(current);
+        }
+    }
+}
+
+void TextureManager::finish(Job& job) {
+    glBindTexture(GL_TEXTURE_2D, 0);
+    Texture& tex = *job.tex;
+    tex.id = job.id;
+    tex.width = job.width;
+    tex.height = job.height;
+    tex.hash = job.hash;
+    tex.resident = true;
+    job = Job();
+    has_current = false;
+    pending--;
+}
+
+bool TextureManager::busy() {
+    return pending > 0;
+}
+
+void TextureManager::shutdown() {
+    {
+        lock_guard<mutex> g(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) worker.join();
+
+    for (GLsync& f : fences) {
+        if (f) glDeleteSync(f);
+        f = 0;
+    }
+    if (current.id) glDeleteTextures(1, &current.id);
+    current = Job();
+    has_current = false;
+    pending = 0;
+    collect();
+    {
+        // хэндлы, которые переживут контекст, больше не трогают GL
+        lock_guard<mutex> g(graveyard->lock);
+        graveyard->closed = true;
+    }
+    for (auto& entry : by_path) {
+        shared_ptr<Texture> t = entry.second.lock();
+        if (!t) continue;
+        if (t->resident) glDeleteTextures(1, &t->id);
+        t->id = 0;
+        t->resident = false;
+    }
+    by_path.clear();
+    by_hash.clear();
+    decode_queue.clear();
+    ready.clear();
+    glDeleteTextures(1, &placeholder_id);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    if (mapped) glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glDeleteBuffers(1, &pbo);
+    mapped = nullptr;
+    pbo = 0;
+    placeholder_id = 0;
+}
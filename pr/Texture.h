@@ -0,0 +1,191 @@
+﻿#pragma once
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <map>
+#include "Assets.h"
+#include "TextureCodec.h"
+
+using namespace std;
+
+struct Texture;
+
+/// <summary>
+/// Общие объекты-сэмплеры. Фильтрация задаётся ими, а не параметрами
+/// текстуры, поэтому одну текстуру можно читать с разными фильтрами.
+/// </summary>
+enum SamplerKind {
+    SAMPLER_TRILINEAR,   // линейная фильтрация между мипмапами, повтор
+    SAMPLER_ANISOTROPIC, // трилинейная + анизотропная (если поддерживается)
+    SAMPLER_CLAMP,       // трилинейная, без повтора по краям
+    SAMPLER_NEAREST,     // без фильтрации
+    SAMPLER_COUNT
+};
+
+class SamplerCache
+{
+public:
+    static SamplerCache& instance();
+
+    /// <summary>
+    /// ID сэмплера; создаётся при первом обращении (нужен GL контекст).
+    /// </summary>
+    GLuint get(SamplerKind kind);
+
+    /// <summary>
+    /// Удаление всех сэмплеров (до glfwTerminate).
+    /// </summary>
+    void clear();
+private:
+    SamplerCache() {}
+    GLuint samplers[SAMPLER_COUNT] = {};
+};
+
+/// <summary>
+/// Текстура. Хэндлы - shared_ptr, выдаваемые TextureManager: одинаковые
+/// изображения загружаются один раз, а GL объект удаляется, когда
+/// освобождается последний хэндл.
+/// </summary>
+struct Texture {
+    string name;
+    uint64_t hash = 0;
+    GLuint id = 0;
+    int width = 0;
+    int height = 0;
+    bool resident = false; // пока false, id указывает на общую заглушку
+    // файл с тем же содержимым уже загружен под другим именем: рисуется он
+    shared_ptr<Texture> same;
+
+    const Texture& image() const { return same ? *same : *this; }
+};
+
+/// <summary>
+/// Привязка текстуры и сэмплера к текстурному блоку. Пока текстура не
+/// загружена, заглушка читается без фильтрации.
+/// </summary>
+void bind_texture(GLuint unit, const Texture& tex, SamplerKind sampler);
+
+/// <summary>
+/// Кэш и асинхронный загрузчик текстур. PNG декодируется в рабочем потоке,
+/// а загрузка на GPU идёт порциями строк через PBO в update(), чтобы
+/// не занимать больше заданного времени кадра. Если рядом с name.png
+/// есть запечённый name.ctex (tools/bake) в поддерживаемом формате,
+/// грузится он: сжатые уровни уходят в glCompressedTexImage2D по одному
+/// за порцию, без декодирования и glGenerateMipmap.
+/// </summary>
+class TextureManager
+{
+public:
+    /// <summary>
+    /// Запуск рабочего потока. Требует текущего GL контекста (создаёт
+    /// заглушку и PBO).
+    /// </summary>
+    /// <param name="pbo_size">Размер одной порции загрузки в байтах.</param>
+    TextureManager(size_t pbo_size = 1 << 20);
+    ~TextureManager();
+
+    /// <summary>
+    /// Хэндл текстуры. Уже загруженное имя возвращает существующую
+    /// текстуру; иначе чтение, хэш и декодирование ставятся в очередь
+    /// рабочего потока. Файл с тем же содержимым, что у загруженной
+    /// текстуры, не декодируется ещё раз: новый хэндл ссылается на неё
+    /// (Texture::same). Возвращается сразу.
+    /// </summary>
+    /// <param name="name">Имя ресурса (см. LoadAsset).</param>
+    shared_ptr<Texture> load(const char* name);
+
+    /// <summary>
+    /// Число живых текстур в кэше.
+    /// </summary>
+    size_t size() const { return by_path.size(); }
+
+    /// <summary>
+    /// Загрузка готовых изображений на GPU. Вызывается каждый кадр из
+    /// потока с GL контекстом.
+    /// </summary>
+    /// <param name="budget_ms">Сколько времени кадра можно потратить.</param>
+    void update(double budget_ms);
+
+    /// <summary>
+    /// Есть ли текстуры, ещё не загруженные на GPU.
+    /// </summary>
+    bool busy();
+
+    /// <summary>
+    /// Остановка потока и удаление всех GL объектов (до glfwTerminate).
+    /// </summary>
+    void shutdown();
+
+    GLuint placeholder() const { return placeholder_id; }
+private:
+    struct Job {
+        shared_ptr<Texture> tex;
+        vector<unsigned char> pixels; // RGBA8
+        int width = 0;
+        int height = 0;
+        GLuint id = 0;
+        int rows_done = 0;
+        // запечённая текстура: уровни ссылаются на данные blob
+        bool compressed = false;
+        AssetBlob blob;
+        CtexImage image;
+        int levels_done = 0;
+        uint64_t hash = 0;
+        shared_ptr<Texture> same; // дубликат по содержимому
+    };
+
+    struct Request {
+        shared_ptr<Texture> tex;
+    };
+
+    // Общая часть с удалителем хэндлов: текстура может умереть в любом
+    // потоке, а GL объект удаляется в update() или уже удалён в shutdown().
+    struct Graveyard {
+        mutex lock;
+        vector<GLuint> ids;
+        bool closed = false;
+    };
+
+    void worker_main();
+    void collect();
+    bool load_baked(Job& job);
+    bool supported(uint32_t format) const;
+    bool stage(const unsigned char* src, size_t bytes, size_t& offset);
+    void release_slot();
+    bool upload_chunk(Job& job);
+    bool upload_level(Job& job);
+    void finish(Job& job);
+    void allocate(GLuint id, GLenum format, int width, int height, int levels, bool compressed);
+
+    thread worker;
+    mutex lock;
+    condition_variable wake;
+    deque<Request> decode_queue;
+    deque<Job> ready;
+    bool stopping = false;
+    map<uint64_t, weak_ptr<Texture>> by_hash; // только рабочий поток
+
+    // состояние на стороне GL потока
+    map<string, weak_ptr<Texture>> by_path;
+    shared_ptr<Graveyard> graveyard;
+    Job current;
+    bool has_current = false;
+    int pending = 0;
+
+    bool has_storage = false; // glTexStorage2D (4.2 / ARB_texture_storage)
+    bool has_s3tc = false;
+    bool has_bptc = false;
+
+    GLuint placeholder_id = 0;
+    static const int pbo_slots = 3;
+    GLuint pbo = 0;
+    size_t slot_size = 0;
+    unsigned char* mapped = nullptr; // постоянное отображение, если есть ARB_buffer_storage
+    GLsync fences[pbo_slots] = {};
+    int slot = 0;
+};
@@ -0,0 +1,333 @@
+﻿// TextureCodec.cpp
+#include "TextureCodec.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+    float srgb_to_linear_lut[256];
+    bool lut_ready = false;
+
+    void init_lut() {
+        if (lut_ready) return;
+        for (int i = 0; i < 256; i++) {
+            float c = i / 255.0f;
+            srgb_to_linear_lut[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        lut_ready = true;
+    }
+
+    unsigned char linear_to_srgb(float c) {
+        c = std::min(std::max(c, 0.0f), 1.0f);
+        float s = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+        return (unsigned char)(s * 255.0f + 0.5f);
+    }
+
+    // Следующий уровень мипмапа: среднее 2x2 в линейном пространстве.
+    vector<unsigned char> downsample(const vector<unsigned char>& src, int w, int h, int nw, int nh) {
+        vector<unsigned char> dst((size_t)nw * nh * 4);
+        for (int y = 0; y < nh; y++) {
+            for (int x = 0; x < nw; x++) {
+                int x0 = std::min(x * 2, w - 1), x1 = std::min(x * 2 + 1, w - 1);
+                int y0 = std::min(y * 2, h - 1), y1 = std::min(y * 2 + 1, h - 1);
+                const unsigned char* p[4] = {
+                    &src[((size_t)y0 * w + x0) * 4], &src[((size_t)y0 * w + x1) * 4],
+                    &src[((size_t)y1 * w + x0) * 4], &src[((size_t)y1 * w + x1) * 4],
+                };
+                unsigned char* out = &dst[((size_t)y * nw + x) * 4];
+                for (int c = 0; c < 3; c++) {
+                    float sum = 0;
+                    for (int i = 0; i < 4; i++) sum += srgb_to_linear_lut[p[i][c]];
+                    out[c] = linear_to_srgb(sum * 0.25f);
+                }
+                out[3] = (unsigned char)((p[0][3] + p[1][3] + p[2][3] + p[3][3] + 2) / 4);
+            }
+        }
+        return dst;
+    }
+
+    // Концы отрезка, приближающего цвета блока: главная ось (степенной
+    // метод по ковариации) и крайние проекции пикселей на неё.
+    void fit_endpoints(const unsigned char block[64], int channels, float e0[4], float e1[4]) {
+        float mean[4] = {};
+        for (int i = 0; i < 16; i++)
+            for (int c = 0; c < channels; c++) mean[c] += block[i * 4 + c];
+        for (int c = 0; c < channels; c++) mean[c] /= 16.0f;
+
+        float cov[4][4] = {};
+        for (int i = 0; i < 16; i++) {
+            float d[4];
+            for (int c = 0; c < channels; c++) d[c] = block[i * 4 + c] - mean[c];
+            for (int a = 0; a < channels; a++)
+                for (int b = 0; b < channels; b++) cov[a][b] += d[a] * d[b];
+        }
+
+        float axis[4] = { 1, 1, 1, 1 };
+        for (int iter = 0; iter < 8; iter++) {
+            float next[4] = {};
+            for (int a = 0; a < channels; a++)
+                for (int b = 0; b < channels; b++) next[a] += cov[a][b] * axis[b];
+            float len = 0;
+            for (int c = 0; c < channels; c++) len += next[c] * next[c];
+            if (len < 1e-12f) break;
+            len = std::sqrt(len);
+            for (int c = 0; c < channels; c++) axis[c] = next[c] / len;
+        }
+
+        float tmin = 0, tmax = 0;
+        for (int i = 0; i < 16; i++) {
+            float t = 0;
+            for (int c = 0; c < channels; c++) t += (block[i * 4 + c] - mean[c]) * axis[c];
+            tmin = std::min(tmin, t);
+            tmax = std::max(tmax, t);
+        }
+        for (int c = 0; c < channels; c++) {
+            e0[c] = std::min(std::max(mean[c] + axis[c] * tmax, 0.0f), 255.0f);
+            e1[c] = std::min(std::max(mean[c] + axis[c] * tmin, 0.0f), 255.0f);
+        }
+    }
+
+    uint16_t to565(const float c[3]) {
+        int r = (int)(c[0] * 31.0f / 255.0f + 0.5f);
+        int g = (int)(c[1] * 63.0f / 255.0f + 0.5f);
+        int b = (int)(c[2] * 31.0f / 255.0f + 0.5f);
+        return (uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    void from565(uint16_t v, int out[3]) {
+        int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+        out[0] = (r << 3) | (r >> 2);
+        out[1] = (g << 2) | (g >> 4);
+        out[2] = (b << 3) | (b >> 2);
+    }
+
+    void put16(unsigned char* p, uint32_t v) {
+        p[0] = (unsigned char)v;
+        p[1] = (unsigned char)(v >> 8);
+    }
+
+    // Запись битов младшими вперёд, как того требует BC7.
+    struct BitWriter {
+        unsigned char* out;
+        int pos = 0;
+        explicit BitWriter(unsigned char* o) : out(o) { memset(out, 0, 16); }
+        void write(uint32_t value, int bits) {
+            for (int i = 0; i < bits; i++, pos++)
+                if (value & (1u << i)) out[pos >> 3] |= (unsigned char)(1u << (pos & 7));
+        }
+    };
+
+    void encode_alpha(const unsigned char block[64], unsigned char out[8]) {
+        int a0 = 0, a1 = 255;
+        for (int i = 0; i < 16; i++) {
+            a0 = std::max(a0, (int)block[i * 4 + 3]);
+            a1 = std::min(a1, (int)block[i * 4 + 3]);
+        }
+        out[0] = (unsigned char)a0;
+        out[1] = (unsigned char)a1;
+        memset(out + 2, 0, 6);
+        if (a0 == a1) return;
+
+        int palette[8] = { a0, a1 };
+        for (int i = 1; i < 7; i++) palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+        uint64_t bits = 0;
+        for (int i = 0; i < 16; i++) {
+            int a = block[i * 4 + 3], best = 0, best_err = 1 << 30;
+            for (int k = 0; k < 8; k++) {
+                int err = std::abs(palette[k] - a);
+                if (err < best_err) { best_err = err; best = k; }
+            }
+            bits |= (uint64_t)best << (3 * i);
+        }
+        for (int i = 0; i < 6; i++) out[2 + i] = (unsigned char)(bits >> (8 * i));
+    }
+
+    void quantize_bc7(const float e[4], int q[4], int& p) {
+        int best_err = 1 << 30;
+        for (int pb = 0; pb < 2; pb++) {
+            int cand[4], err = 0;
+            for (int c = 0; c < 4; c++) {
+                cand[c] = std::min(std::max((int)std::floor((e[c] - pb) / 2.0f + 0.5f), 0), 127);
+                int d = ((cand[c] << 1) | pb) - (int)(e[c] + 0.5f);
+                err += d * d;
+            }
+            if (err < best_err) {
+                best_err = err;
+                p = pb;
+                for (int c = 0; c < 4; c++) q[c] = cand[c];
+            }
+        }
+    }
+
+    void extract_block(const unsigned char* rgba, int w, int h, int bx, int by, unsigned char block[64]) {
+        for (int y = 0; y < 4; y++) {
+            int sy = std::min(by * 4 + y, h - 1);
+            for (int x = 0; x < 4; x++) {
+                int sx = std::min(bx * 4 + x, w - 1);
+                memcpy(&block[(y * 4 + x) * 4], &rgba[((size_t)sy * w + sx) * 4], 4);
+            }
+        }
+    }
+}
+
+void EncodeBC1(const unsigned char block[64], unsigned char out[8]) {
+    float e0[4], e1[4];
+    fit_endpoints(block, 3, e0, e1);
+    uint16_t c0 = to565(e0), c1 = to565(e1);
+    if (c0 < c1) std::swap(c0, c1);
+    put16(out, c0);
+    put16(out + 2, c1);
+    uint32_t bits = 0;
+    if (c0 != c1) {
+        int p[4][3];
+        from565(c0, p[0]);
+        from565(c1, p[1]);
+        for (int c = 0; c < 3; c++) {
+            p[2][c] = (2 * p[0][c] + p[1][c]) / 3;
+            p[3][c] = (p[0][c] + 2 * p[1][c]) / 3;
+        }
+        for (int i = 0; i < 16; i++) {
+            int best = 0, best_err = 1 << 30;
+            for (int k = 0; k < 4; k++) {
+                int err = 0;
+                for (int c = 0; c < 3; c++) {
+                    int d = p[k][c] - block[i * 4 + c];
+                    err += d * d;
+                }
+                if (err < best_err) { best_err = err; best = k; }
+            }
+            bits |= (uint32_t)best << (2 * i);
+        }
+    }
+    for (int i = 0; i < 4; i++) out[4 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+void EncodeBC3(const unsigned char block[64], unsigned char out[16]) {
+    encode_alpha(block, out);
+    EncodeBC1(block, out + 8);
+}
+
+// BC7 режим 6: одна подгруппа, концы RGBA по 7 бит + p-бит, индексы по 4 бита.
+void EncodeBC7(const unsigned char block[64], unsigned char out[16]) {
+    static const int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+    float e0[4], e1[4];
+    fit_endpoints(block, 4, e0, e1);
+    int q0[4], q1[4], p0 = 0, p1 = 0;
+    quantize_bc7(e0, q0, p0);
+    quantize_bc7(e1, q1, p1);
+
+    int palette[16][4];
+    for (int k = 0; k < 16; k++)
+        for (int c = 0; c < 4; c++) {
+            int a = (q0[c] << 1) | p0, b = (q1[c] << 1) | p1;
+            palette[k][c] = ((64 - weights[k]) * a + weights[k] * b + 32) >> 6;
+        }
+
+    int idx[16];
+    for (int i = 0; i < 16; i++) {
+        int best = 0, best_err = 1 << 30;
+        for (int k = 0; k < 16; k++) {
+            int err = 0;
+            for (int c = 0; c < 4; c++) {
+                int d = palette[k][c] - block[i * 4 + c];
+                err += d * d;
+            }
+            if (err < best_err) { best_err = err; best = k; }
+        }
+        idx[i] = best;
+    }
+    // старший бит индекса первого пикселя не хранится и должен быть нулём
+    if (idx[0] & 8) {
+        std::swap(q0, q1);
+        std::swap(p0, p1);
+        for (int i = 0; i < 16; i++) idx[i] = 15 - idx[i];
+    }
+
+    BitWriter bw(out);
+    bw.write(1u << 6, 7);
+    for (int c = 0; c < 4; c++) {
+        bw.write(q0[c], 7);
+        bw.write(q1[c], 7);
+    }
+    bw.write(p0, 1);
+    bw.write(p1, 1);
+    bw.write(idx[0], 3);
+    for (int i = 1; i < 16; i++) bw.write(idx[i], 4);
+}
+
+size_t CtexBlockBytes(uint32_t format) {
+    return format == CTEX_BC1 ? 8 : 16;
+}
+
+vector<unsigned char> BakeCtex(const unsigned char* rgba, int width, int height, uint32_t format) {
+    init_lut();
+    size_t block_bytes = CtexBlockBytes(format);
+
+    vector<vector<unsigned char>> levels;
+    vector<unsigned char> image(rgba, rgba + (size_t)width * height * 4);
+    int w = width, h = height;
+    for (;;) {
+        int bw = (w + 3) / 4, bh = (h + 3) / 4;
+        vector<unsigned char> blocks((size_t)bw * bh * block_bytes);
+        unsigned char block[64];
+        for (int by = 0; by < bh; by++)
+            for (int bx = 0; bx < bw; bx++) {
+                extract_block(image.data(), w, h, bx, by, block);
+                unsigned char* dst = &blocks[((size_t)by * bw + bx) * block_bytes];
+                if (format == CTEX_BC1) EncodeBC1(block, dst);
+                else if (format == CTEX_BC3) EncodeBC3(block, dst);
+                else EncodeBC7(block, dst);
+            }
+        levels.push_back(std::move(blocks));
+        if (w == 1 && h == 1) break;
+        int nw = std::max(1, w / 2), nh = std::max(1, h / 2);
+        image = downsample(image, w, h, nw, nh);
+        w = nw;
+        h = nh;
+    }
+
+    CtexHeader header = { CTEX_MAGIC, CTEX_VERSION, format, (uint32_t)width, (uint32_t)height, (uint32_t)levels.size() };
+    vector<CtexLevelEntry> entries(levels.size());
+    size_t offset = sizeof(header) + sizeof(CtexLevelEntry) * levels.size();
+    for (size_t i = 0; i < levels.size(); i++) {
+        offset = (offset + CTEX_ALIGN - 1) / CTEX_ALIGN * CTEX_ALIGN;
+        entries[i].offset = (uint32_t)offset;
+        entries[i].size = (uint32_t)levels[i].size();
+        offset += levels[i].size();
+    }
+
+    vector<unsigned char> out(offset, 0);
+    memcpy(out.data(), &header, sizeof(header));
+    memcpy(out.data() + sizeof(header), entries.data(), sizeof(CtexLevelEntry) * entries.size());
+    for (size_t i = 0; i < levels.size(); i++)
+        memcpy(out.data() + entries[i].offset, levels[i].data(), levels[i].size());
+    return out;
+}
+
+bool ParseCtex(const unsigned char* data, size_t size, CtexImage& out) {
+    if (size < sizeof(CtexHeader)) return false;
+    CtexHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != CTEX_MAGIC || header.version != CTEX_VERSION) return false;
+    if (header.levels == 0 || header.levels > 32) return false;
+    if (size < sizeof(header) + sizeof(CtexLevelEntry) * header.levels) return false;
+
+    out.format = header.format;
+    out.width = (int)header.width;
+    out.height = (int)header.height;
+    out.levels.clear();
+    size_t block_bytes = CtexBlockBytes(header.format);
+    for (uint32_t i = 0; i < header.levels; i++) {
+        CtexLevelEntry e;
+        memcpy(&e, data + sizeof(header) + sizeof(e) * i, sizeof(e));
+        CtexLevel level;
+        level.width = std::max(1, out.width >> i);
+        level.height = std::max(1, out.height >> i);
+        level.data = data + e.offset;
+        level.size = e.size;
+        size_t expected = (size_t)((level.width + 3) / 4) * ((level.height + 3) / 4) * block_bytes;
+        if ((size_t)e.offset + e.size > size || e.size != expected) return false;
+        out.levels.push_back(level);
+    }
+    return true;
+}
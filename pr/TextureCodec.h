@@ -0,0 +1,75 @@
+﻿#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// Формат контейнера .ctex (по мотивам KTX):
+//   CtexHeader
+//   CtexLevelEntry[levels]  - смещение и размер каждого уровня от начала файла
+//   данные уровней, каждый выровнен на CTEX_ALIGN байт
+// Все поля little-endian. Формат хранится как internal format OpenGL, чтобы
+// загрузчик передавал его в glCompressedTexImage2D без таблиц соответствия.
+
+const uint32_t CTEX_MAGIC = 0x58455443; // "CTEX"
+const uint32_t CTEX_VERSION = 1;
+const uint32_t CTEX_ALIGN = 16;
+
+const uint32_t CTEX_BC1 = 0x83F0; // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+const uint32_t CTEX_BC3 = 0x83F3; // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+const uint32_t CTEX_BC7 = 0x8E8C; // GL_COMPRESSED_RGBA_BPTC_UNORM
+
+struct CtexHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t levels;
+};
+
+struct CtexLevelEntry {
+    uint32_t offset;
+    uint32_t size;
+};
+
+/// <summary>
+/// Уровень мипмапа внутри загруженного файла (указывает в его данные).
+/// </summary>
+struct CtexLevel {
+    int width;
+    int height;
+    const unsigned char* data;
+    size_t size;
+};
+
+struct CtexImage {
+    uint32_t format = 0;
+    int width = 0;
+    int height = 0;
+    vector<CtexLevel> levels;
+};
+
+/// <summary>
+/// Разбор .ctex без копирования: уровни ссылаются на data.
+/// </summary>
+/// <returns>false, если файл повреждён или неизвестной версии.</returns>
+bool ParseCtex(const unsigned char* data, size_t size, CtexImage& out);
+
+/// <summary>
+/// Размер блока 4x4 в байтах для формата (8 для BC1, 16 для BC3/BC7).
+/// </summary>
+size_t CtexBlockBytes(uint32_t format);
+
+/// <summary>
+/// Построение полной цепочки мипмапов и сжатие в .ctex. Уменьшение идёт
+/// фильтром 2x2 в линейном пространстве (цвет считается sRGB).
+/// </summary>
+/// <param name="rgba">Исходное изображение RGBA8.</param>
+vector<unsigned char> BakeCtex(const unsigned char* rgba, int width, int height, uint32_t format);
+
+// Кодирование одного блока 4x4 (16 пикселей RGBA8 по строкам).
+void EncodeBC1(const unsigned char block[64], unsigned char out[8]);
+void EncodeBC3(const unsigned char block[64], unsigned char out[16]);
+void EncodeBC7(const unsigned char block[64], unsigned char out[16]);
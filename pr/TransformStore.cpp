@@ -0,0 +1,160 @@
+﻿// TransformStore.cpp
+#include "TransformStore.h"
+#include <cmath>
+#include <algorithm>
+
+namespace {
+    const float DEG = 3.14159265358979323846f / 180.0f;
+}
+
+TransformStore::Entity TransformStore::create(Entity p) {
+    Entity e = (Entity)parent.size();
+    parent.push_back(p < e ? p : -1);
+    pos_x.push_back(0.0f); pos_y.push_back(0.0f); pos_z.push_back(0.0f);
+    rot_x.push_back(0.0f); rot_y.push_back(0.0f); rot_z.push_back(0.0f);
+    scale_x.push_back(1.0f); scale_y.push_back(1.0f); scale_z.push_back(1.0f);
+    local_m.push_back(glm::mat4(1.0f));
+    world_m.push_back(glm::mat4(1.0f));
+    dirty.push_back(0);
+    bounded.push_back(0);
+    in_moved.push_back(0);
+    for (vector<float>* v : { &lmin_x, &lmin_y, &lmin_z, &lmax_x, &lmax_y, &lmax_z,
+                              &wmin_x, &wmin_y, &wmin_z, &wmax_x, &wmax_y, &wmax_z })
+        v->push_back(0.0f);
+    mark(e);
+    return e;
+}
+
+void TransformStore::clear() {
+    *this = TransformStore();
+}
+
+void TransformStore::mark(Entity e) {
+    dirty[e] = 1;
+    first_dirty = std::min(first_dirty, (size_t)e);
+}
+
+void TransformStore::set_position(Entity e, const glm::vec3& p) {
+    if (pos_x[e] == p.x && pos_y[e] == p.y && pos_z[e] == p.z) return;
+    pos_x[e] = p.x; pos_y[e] = p.y; pos_z[e] = p.z;
+    mark(e);
+}
+
+void TransformStore::set_rotation(Entity e, const glm::vec3& r) {
+    if (rot_x[e] == r.x && rot_y[e] == r.y && rot_z[e] == r.z) return;
+    rot_x[e] = r.x; rot_y[e] = r.y; rot_z[e] = r.z;
+    mark(e);
+}
+
+void TransformStore::set_scale(Entity e, const glm::vec3& s) {
+    if (scale_x[e] == s.x && scale_y[e] == s.y && scale_z[e] == s.z) return;
+    scale_x[e] = s.x; scale_y[e] = s.y; scale_z[e] = s.z;
+    mark(e);
+}
+
+void TransformStore::set_bounds(Entity e, const glm::vec3& lo, const glm::vec3& hi) {
+    lmin_x[e] = lo.x; lmin_y[e] = lo.y; lmin_z[e] = lo.z;
+    lmax_x[e] = hi.x; lmax_y[e] = hi.y; lmax_z[e] = hi.z;
+    bounded[e] = 1;
+    mark(e);
+}
+
+void TransformStore::update() {
+    size_t n = parent.size();
+    if (first_dirty >= n) return;
+    size_t from = first_dirty;
+    first_dirty = SIZE_MAX;
+
+    // Изменение родителя делает изменёнными всех потомков: родитель стоит
+    // раньше, так что хватает одного прохода.
+    for (size_t i = from; i < n; i++)
+        if (parent[i] >= 0 && dirty[parent[i]]) dirty[i] = 1;
+
+    // Локальные матрицы T * Ry * Rx * Rz * S, расписанные поэлементно.
+    for (size_t i = from; i < n; i++) {
+        if (!dirty[i]) continue;
+        float cx = std::cos(rot_x[i] * DEG), sx = std::sin(rot_x[i] * DEG);
+        float cy = std::cos(rot_y[i] * DEG), sy = std::sin(rot_y[i] * DEG);
+        float cz = std::cos(rot_z[i] * DEG), sz = std::sin(rot_z[i] * DEG);
+        glm::mat4& m = local_m[i];
+        m[0][0] = (cy * cz + sy * sx * sz) * scale_x[i];
+        m[0][1] = (cx * sz) * scale_x[i];
+        m[0][2] = (-sy * cz + cy * sx * sz) * scale_x[i];
+        m[0][3] = 0.0f;
+        m[1][0] = (-cy * sz + sy * sx * cz) * scale_y[i];
+        m[1][1] = (cx * cz) * scale_y[i];
+        m[1][2] = (sy * sz + cy * sx * cz) * scale_y[i];
+        m[1][3] = 0.0f;
+        m[2][0] = (sy * cx) * scale_z[i];
+        m[2][1] = (-sx) * scale_z[i];
+        m[2][2] = (cy * cx) * scale_z[i];
+        m[2][3] = 0.0f;
+        m[3][0] = pos_x[i];
+        m[3][1] = pos_y[i];
+        m[3][2] = pos_z[i];
+        m[3][3] = 1.0f;
+    }
+
+    for (size_t i = from; i < n; i++) {
+        if (!dirty[i]) continue;
+        world_m[i] = parent[i] >= 0 ? world_m[parent[i]] * local_m[i] : local_m[i];
+    }
+
+    // Мировой AABB: центр переносится матрицей, полуразмеры - модулем
+    // её линейной части (метод Арво).
+    for (size_t i = from; i < n; i++) {
+        if (!dirty[i]) continue;
+        const glm::mat4& m = world_m[i];
+        float cx = (lmin_x[i] + lmax_x[i]) * 0.5f, ex = (lmax_x[i] - lmin_x[i]) * 0.5f;
+        float cy = (lmin_y[i] + lmax_y[i]) * 0.5f, ey = (lmax_y[i] - lmin_y[i]) * 0.5f;
+        float cz = (lmin_z[i] + lmax_z[i]) * 0.5f, ez = (lmax_z[i] - lmin_z[i]) * 0.5f;
+        float wx = m[0][0] * cx + m[1][0] * cy + m[2][0] * cz + m[3][0];
+        float wy = m[0][1] * cx + m[1][1] * cy + m[2][1] * cz + m[3][1];
+        float wz = m[0][2] * cx + m[1][2] * cy + m[2][2] * cz + m[3][2];
+        float rx = std::fabs(m[0][0]) * ex + std::fabs(m[1][0]) * ey + std::fabs(m[2][0]) * ez;
+        float ry = std::fabs(m[0][1]) * ex + std::fabs(m[1][1]) * ey + std::fabs(m[2][1]) * ez;
+        float rz = std::fabs(m[0][2]) * ex + std::fabs(m[1][2]) * ey + std::fabs(m[2][2]) * ez;
+        wmin_x[i] = wx - rx; wmax_x[i] = wx + rx;
+        wmin_y[i] = wy - ry; wmax_y[i] = wy + ry;
+        wmin_z[i] = wz - rz; wmax_z[i] = wz + rz;
+    }
+
+    for (size_t i = from; i < n; i++) {
+        if (!dirty[i] || in_moved[i]) continue;
+        in_moved[i] = 1;
+        moved.push_back((Entity)i);
+    }
+    std::fill(dirty.begin() + from, dirty.end(), (uint8_t)0);
+}
+
+void TransformStore::take_moved(vector<Entity>& out) {
+    out.clear();
+    out.swap(moved);
+    for (Entity e : out) in_moved[e] = 0;
+}
+
+void TransformStore::save_previous() {
+    previous_m = world_m;
+}
+
+glm::mat4 TransformStore::interpolated(Entity e, float alpha) const {
+    const glm::mat4& b = world_m[e];
+    if ((size_t)e >= previous_m.size()) return b; // сущность появилась после save_previous()
+    const glm::mat4& a = previous_m[e];
+    if (a == b) return b;
+    glm::mat4 m;
+    for (int c = 0; c < 3; c++) {
+        glm::vec3 ca(a[c]), cb(b[c]);
+        float la = glm::length(ca), lb = glm::length(cb);
+        glm::vec3 dir = ca + (cb - ca) * alpha;
+        float l = glm::length(dir);
+        m[c] = glm::vec4(l > 0.0f ? dir * ((la + (lb - la) * alpha) / l) : dir, 0.0f);
+    }
+    m[3] = a[3] + (b[3] - a[3]) * alpha;
+    return m;
+}
+
+void TransformStore::world_bounds(Entity e, glm::vec3& lo, glm::vec3& hi) const {
+    lo = glm::vec3(wmin_x[e], wmin_y[e], wmin_z[e]);
+    hi = glm::vec3(wmax_x[e], wmax_y[e], wmax_z[e]);
+}
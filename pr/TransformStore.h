@@ -0,0 +1,85 @@
+﻿#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+/// <summary>
+/// Преобразования сущностей в виде структуры массивов: каждая компонента
+/// (x, y, z положения, углы, масштаб, границы) лежит в своём непрерывном
+/// массиве, поэтому пересчёт матриц и границ - плотные циклы без
+/// ветвлений по объектам, которые компилятор векторизует.
+///
+/// Сущность - индекс. Родитель всегда создаётся раньше ребёнка, так что
+/// иерархия обходится одним проходом по возрастанию индексов.
+/// </summary>
+class TransformStore
+{
+public:
+    typedef int Entity;
+
+    /// <param name="parent">Родитель (-1 - корень); должен уже существовать.</param>
+    Entity create(Entity parent = -1);
+    size_t size() const { return parent.size(); }
+    void clear();
+
+    void set_position(Entity e, const glm::vec3& p);
+    void set_rotation(Entity e, const glm::vec3& degrees); // порядок Y-X-Z
+    void set_scale(Entity e, const glm::vec3& s);
+    glm::vec3 position(Entity e) const { return glm::vec3(pos_x[e], pos_y[e], pos_z[e]); }
+    glm::vec3 rotation(Entity e) const { return glm::vec3(rot_x[e], rot_y[e], rot_z[e]); }
+    glm::vec3 scale(Entity e) const { return glm::vec3(scale_x[e], scale_y[e], scale_z[e]); }
+    Entity parent_of(Entity e) const { return parent[e]; }
+
+    /// <summary>
+    /// Локальный AABB сетки сущности; без него сущность не отсекается.
+    /// </summary>
+    void set_bounds(Entity e, const glm::vec3& lo, const glm::vec3& hi);
+
+    /// <summary>
+    /// Пересчёт изменённых сущностей и их потомков: локальные матрицы,
+    /// мировые матрицы, мировые AABB. Без изменений ничего не делает.
+    /// </summary>
+    void update();
+
+    const glm::mat4& world(Entity e) const { return world_m[e]; }
+
+    /// <summary>
+    /// Запоминание текущих мировых матриц как состояния предыдущего шага
+    /// симуляции (для interpolated()).
+    /// </summary>
+    void save_previous();
+
+    /// <summary>
+    /// Мировая матрица между сохранённой save_previous() (alpha = 0) и
+    /// текущей (alpha = 1): перенос интерполируется линейно, оси базиса -
+    /// по направлению и длине отдельно, чтобы поворот не сжимал объект.
+    /// </summary>
+    glm::mat4 interpolated(Entity e, float alpha) const;
+    const glm::mat4* world_data() const { return world_m.data(); }
+    void world_bounds(Entity e, glm::vec3& lo, glm::vec3& hi) const;
+
+    bool has_bounds(Entity e) const { return bounded[e] != 0; }
+
+    /// <summary>
+    /// Сущности, пересчитанные update() с прошлого вызова (каждая один
+    /// раз): по ним обновляются внешние структуры вроде AabbTree.
+    /// </summary>
+    void take_moved(vector<Entity>& out);
+private:
+    void mark(Entity e);
+
+    vector<Entity> parent;
+    vector<float> pos_x, pos_y, pos_z;
+    vector<float> rot_x, rot_y, rot_z;
+    vector<float> scale_x, scale_y, scale_z;
+    vector<glm::mat4> local_m, world_m, previous_m;
+    vector<uint8_t> dirty;
+    vector<uint8_t> bounded;
+    vector<uint8_t> in_moved;
+    vector<Entity> moved;
+    vector<float> lmin_x, lmin_y, lmin_z, lmax_x, lmax_y, lmax_z;
+    vector<float> wmin_x, wmin_y, wmin_z, wmax_x, wmax_y, wmax_z;
+    size_t first_dirty = SIZE_MAX;  // нижняя граница изменённых индексов
+};
@@ -0,0 +1,150 @@
+﻿// Tube.cpp
+#include "Tube.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define TUBE_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+    const float PI = 3.14159265358979323846f;
+
+    // нормаль, перпендикулярная t: ось, наименее сонаправленная с t, минус её проекция
+    glm::vec3 any_normal(const glm::vec3& t) {
+        glm::vec3 a = std::fabs(t.x) < std::fabs(t.y) ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+        if (std::fabs(t.z) < std::min(std::fabs(t.x), std::fabs(t.y))) a = glm::vec3(0, 0, 1);
+        return glm::normalize(a - t * glm::dot(a, t));
+    }
+}
+
+void TubeSweep::build(const glm::vec3* points, int n, float radius, int radial, glm::vec3* out) {
+    if (n < 2 || radial < 3) return;
+    for (vector<float>* v : { &px, &py, &pz, &tx, &ty, &tz, &nx, &ny, &nz, &bx, &by, &bz,
+                              &v1x, &v1y, &v1z, &k1, &v2x, &v2y, &v2z, &k2 })
+        v->resize(n);
+    for (int i = 0; i < n; i++) {
+        px[i] = points[i].x;
+        py[i] = points[i].y;
+        pz[i] = points[i].z;
+    }
+
+    // Касательные: разность соседей, на концах - односторонняя. Циклы без
+    // зависимостей между точками компилятор векторизует сам.
+    for (int i = 0; i < n; i++) {
+        int a = std::max(i - 1, 0), b = std::min(i + 1, n - 1);
+        float dx = px[b] - px[a], dy = py[b] - py[a], dz = pz[b] - pz[a];
+        float l2 = dx * dx + dy * dy + dz * dz;
+        float inv = l2 > 1e-16f ? 1.0f / std::sqrt(l2) : 0.0f;
+        tx[i] = dx * inv; ty[i] = dy * inv; tz[i] = dz * inv;
+    }
+    // совпавшие точки: касательная соседа (редкий случай)
+    for (int i = 0; i < n; i++) {
+        if (tx[i] != 0.0f || ty[i] != 0.0f || tz[i] != 0.0f) continue;
+        tx[i] = i > 0 ? tx[i - 1] : 1.0f;
+        ty[i] = i > 0 ? ty[i - 1] : 0.0f;
+        tz[i] = i > 0 ? tz[i - 1] : 0.0f;
+    }
+
+    // Параллельный перенос методом двойного отражения (Wang et al., 2008):
+    // рамка переходит в точку i отражением в плоскости, перпендикулярной
+    // v1 = p[i] - p[i-1], и затем в плоскости, переводящей отражённую
+    // касательную в t[i]. Обе плоскости от рамки не зависят и считаются
+    // заранее, в цепочке от точки к точке остаются два скалярных
+    // произведения.
+    for (int i = 1; i < n; i++) {
+        float ax = px[i] - px[i - 1], ay = py[i] - py[i - 1], az = pz[i] - pz[i - 1];
+        float c1 = ax * ax + ay * ay + az * az;
+        float k = c1 > 1e-12f ? 2.0f / c1 : 0.0f;
+        float d = k * (ax * tx[i - 1] + ay * ty[i - 1] + az * tz[i - 1]);
+        float ex = tx[i] - (tx[i - 1] - d * ax);
+        float ey = ty[i] - (ty[i - 1] - d * ay);
+        float ez = tz[i] - (tz[i - 1] - d * az);
+        float c2 = ex * ex + ey * ey + ez * ez;
+        v1x[i] = ax; v1y[i] = ay; v1z[i] = az; k1[i] = k;
+        v2x[i] = ex; v2y[i] = ey; v2z[i] = ez; k2[i] = c2 > 1e-12f ? 2.0f / c2 : 0.0f;
+    }
+    glm::vec3 r = any_normal(glm::vec3(tx[0], ty[0], tz[0]));
+    nx[0] = r.x; ny[0] = r.y; nz[0] = r.z;
+    for (int i = 1; i < n; i++) {
+        float d = k1[i] * (v1x[i] * r.x + v1y[i] * r.y + v1z[i] * r.z);
+        r.x -= d * v1x[i]; r.y -= d * v1y[i]; r.z -= d * v1z[i];
+        d = k2[i] * (v2x[i] * r.x + v2y[i] * r.y + v2z[i] * r.z);
+        r.x -= d * v2x[i]; r.y -= d * v2y[i]; r.z -= d * v2z[i];
+        if ((i & 31) == 0) { // отражения сохраняют длину, но ошибка округления копится
+            glm::vec3 t(tx[i], ty[i], tz[i]);
+            r = glm::normalize(r - t * glm::dot(r, t));
+        }
+        nx[i] = r.x; ny[i] = r.y; nz[i] = r.z;
+    }
+    for (int i = 0; i < n; i++) {
+        bx[i] = ty[i] * nz[i] - tz[i] * ny[i];
+        by[i] = tz[i] * nx[i] - tx[i] * nz[i];
+        bz[i] = tx[i] * ny[i] - ty[i] * nx[i];
+    }
+
+    // Кольца: вершина = ось + (n cos + b sin) * радиус, для сектора j
+    // по четыре точки оси за итерацию.
+    for (int j = 0; j < radial; j++) {
+        float angle = 2.0f * PI * j / radial;
+        float c = std::cos(angle) * radius, s = std::sin(angle) * radius;
+        glm::vec3* ring = out + (size_t)j * n;
+        int i = 0;
+#ifdef TUBE_SSE
+        __m128 c4 = _mm_set1_ps(c), s4 = _mm_set1_ps(s);
+        for (; i + 4 <= n; i += 4) {
+            __m128 x = _mm_add_ps(_mm_loadu_ps(&px[i]),
+                _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&nx[i]), c4), _mm_mul_ps(_mm_loadu_ps(&bx[i]), s4)));
+            __m128 y = _mm_add_ps(_mm_loadu_ps(&py[i]),
+                _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&ny[i]), c4), _mm_mul_ps(_mm_loadu_ps(&by[i]), s4)));
+            __m128 z = _mm_add_ps(_mm_loadu_ps(&pz[i]),
+                _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&nz[i]), c4), _mm_mul_ps(_mm_loadu_ps(&bz[i]), s4)));
+            // x0..x3, y0..y3, z0..z3 -> x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+            __m128 xy_lo = _mm_unpacklo_ps(x, y);                              // x0 y0 x1 y1
+            __m128 xy_hi = _mm_unpackhi_ps(x, y);                              // x2 y2 x3 y3
+            __m128 t0 = _mm_shuffle_ps(z, xy_lo, _MM_SHUFFLE(2, 2, 0, 0));     // z0 z0 x1 x1
+            __m128 t1 = _mm_shuffle_ps(xy_lo, z, _MM_SHUFFLE(1, 1, 3, 3));     // y1 y1 z1 z1
+            __m128 t2 = _mm_shuffle_ps(z, xy_hi, _MM_SHUFFLE(3, 2, 3, 2));     // z2 z3 x3 y3
+            float* dst = &ring[i].x;
+            _mm_storeu_ps(dst, _mm_shuffle_ps(xy_lo, t0, _MM_SHUFFLE(2, 0, 1, 0)));
+            _mm_storeu_ps(dst + 4, _mm_shuffle_ps(t1, xy_hi, _MM_SHUFFLE(1, 0, 2, 0)));
+            _mm_storeu_ps(dst + 8, _mm_shuffle_ps(t2, t2, _MM_SHUFFLE(1, 3, 2, 0)));
+        }
+#endif
+        for (; i < n; i++) {
+            ring[i] = glm::vec3(px[i] + nx[i] * c + bx[i] * s,
+                py[i] + ny[i] * c + by[i] * s,
+                pz[i] + nz[i] * c + bz[i] * s);
+        }
+    }
+}
+
+SimpleMesh make_tube(const vector<glm::vec3>& points, float radius, int radial, glm::vec3 color) {
+    SimpleMesh m;
+    int n = (int)points.size();
+    if (n < 2 || radial < 3) return m;
+    m.verts.resize((size_t)n * radial);
+    TubeSweep sweep;
+    sweep.build(points.data(), n, radius, radial, m.verts.data());
+
+    m.cols.resize(m.verts.size());
+    for (int j = 0; j < radial; j++) {
+        glm::vec3 shade = color * (0.75f + 0.25f * std::cos(2.0f * PI * j / radial));
+        std::fill(m.cols.begin() + (size_t)j * n, m.cols.begin() + (size_t)(j + 1) * n, shade);
+    }
+
+    for (int j = 0; j < radial; j++) {
+        GLuint a = (GLuint)(j * n), b = (GLuint)(((j + 1) % radial) * n);
+        for (int i = 0; i + 1 < n; i++) {
+            m.inds.push_back(a + i);
+            m.inds.push_back(a + i + 1);
+            m.inds.push_back(b + i);
+
+            m.inds.push_back(a + i + 1);
+            m.inds.push_back(b + i + 1);
+            m.inds.push_back(b + i);
+        }
+    }
+    return m;
+}
@@ -0,0 +1,40 @@
+﻿#pragma once
+#include "Mesh.h"
+#include <vector>
+
+using namespace std;
+
+/// <summary>
+/// Круглая трубка вдоль ломаной. Кольца ориентированы рамками
+/// параллельного переноса (метод двойного отражения): рамка не
+/// закручивается вдоль кривой и не вырождается на вертикальных участках,
+/// в отличие от ленты, повёрнутой по фиксированному "вверх".
+///
+/// Вершины идут кольцами по образующей: вершина (точка i, сектор j) имеет
+/// номер j * count + i, так что для каждого сектора координаты соседних
+/// точек лежат подряд и считаются по четыре (SSE). Буферы промежуточных
+/// данных хранятся в объекте и переиспользуются между вызовами.
+/// </summary>
+class TubeSweep
+{
+public:
+    /// <summary>
+    /// Координаты вершин трубки, radial * count штук.
+    /// </summary>
+    /// <param name="points">Точки осевой линии (не меньше двух).</param>
+    /// <param name="radial">Секторов по окружности (не меньше трёх).</param>
+    void build(const glm::vec3* points, int count, float radius, int radial, glm::vec3* out);
+private:
+    vector<float> px, py, pz;   // точки оси
+    vector<float> tx, ty, tz;   // касательные
+    vector<float> nx, ny, nz;   // нормали рамок
+    vector<float> bx, by, bz;   // бинормали рамок
+    // плоскости двойного отражения для перехода рамки в точку i
+    vector<float> v1x, v1y, v1z, k1, v2x, v2y, v2z, k2;
+};
+
+/// <summary>
+/// Трубка вдоль ломаной с индексами и цветами: цвет слегка затемняется
+/// по окружности, чтобы без освещения трубка выглядела объёмной.
+/// </summary>
+SimpleMesh make_tube(const vector<glm::vec3>& points, float radius, int radial, glm::vec3 color);
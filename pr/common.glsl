@@ -0,0 +1,17 @@
+// Shared interface between vs.glsl (or the evaluation stage of tess.glsl) and fs.glsl.
+// Stage (VERTEX_SHADER, TESS_*_SHADER, FRAGMENT_SHADER) and feature defines are injected by ShaderCache.
+#if defined(VERTEX_SHADER) || defined(TESS_EVALUATION_SHADER)
+#define VARYING out
+#else
+#define VARYING in
+#endif
+
+#ifdef VERTEX_COLOR
+VARYING vec3 color;
+#endif
+#ifdef TEXTURED
+VARYING vec2 uv;
+#endif
+#ifdef STRIPES
+VARYING vec3 world_pos;
+#endif
@@ -1,13 +1,39 @@
 #version 400
-
-in vec3 color;
-in vec3 world_pos;
+#include "common.glsl"
 
 out vec4 frag_color;
 
+#ifndef VERTEX_COLOR
+uniform vec3 u_color = vec3(1.0);
+#endif
+#ifdef TEXTURED
+uniform sampler2D tex;
+#endif
+#ifdef STRIPES
+uniform float u_time;
+#endif
+
 void main()
 {
+#ifdef VERTEX_COLOR
     vec3 base = color;
+#else
+    vec3 base = u_color;
+#endif
+
+#ifdef TEXTURED
+    base *= texture(tex, uv).rgb;
+#endif
+
+#ifdef STRIPES
+    float coord = world_pos.x * 3.0 + world_pos.y * 2.0 + world_pos.z * 3.0;
+    float stripe = 0.5 + 0.5 * sin((coord + u_time) * 20.0);
+    float band = smoothstep(0.7, 0.72, stripe);
+
+    vec3 glow = vec3(1.0, 0.8, 0.3) * (0.5 * band);
+
+    base += glow;
+#endif
 
     frag_color = vec4(base, 1.0);
 }
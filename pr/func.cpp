@@ -1,16 +1,15 @@
 // func.cpp
 #include "func.h"
 #include "globals.h"
+#include "Assets.h"
 
 string LoadShader(const char* filename) {
-    std::ifstream in(filename);
-    if (!in) {
+    AssetBlob blob = LoadAsset(filename);
+    if (!blob) {
         std::cerr << "Cannot open shader file: " << filename << std::endl;
         return "";
     }
-    std::ostringstream s;
-    s << in.rdbuf();
-    return s.str();
+    return blob.str();
 }
 
 GLFWwindow* InitAll(int w, int h, bool Fullscreen) {
@@ -12,7 +12,7 @@
 
 using namespace std;
 /// <summary> 
-///     
+///     ( LoadAsset:    ) 
 /// </summary> 
 /// <param name="filename">  .</param> 
 /// <returns>   .</returns> 
@@ -2,6 +2,13 @@
 #include "model.h"
 #include "func.h"
 #include "globals.h"
+#include "Texture.h"
+#include "MeshImporter.h"
+#include "Scene.h"
+#include "Assets.h"
+#include "FixedTimestep.h"
+#include "RenderList.h"
+#include "FrameFences.h"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -9,6 +16,8 @@
 
 #include <vector>
 #include <cmath>
+#include <chrono>
+#include <cstdio>
 #include <iostream>
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb-master/stb_image.h"
@@ -16,197 +25,6 @@
 int WinWidth;
 int WinHeight;
 
-struct SimpleMesh {
-    std::vector<glm::vec3> verts;
-    std::vector<glm::vec3> cols;
-    std::vector<glm::vec2> uvs;
-    std::vector<GLuint> inds;
-};
-
-SimpleMesh make_box(glm::vec3 center, glm::vec3 size, glm::vec3 color) {
-    glm::vec3 hs = size * 0.5f;
-    glm::vec3 v[8] = {
-        center + glm::vec3(-hs.x, -hs.y, -hs.z),
-        center + glm::vec3(hs.x, -hs.y, -hs.z),
-        center + glm::vec3(hs.x,  hs.y, -hs.z),
-        center + glm::vec3(-hs.x,  hs.y, -hs.z),
-
-        center + glm::vec3(-hs.x, -hs.y,  hs.z),
-        center + glm::vec3(hs.x, -hs.y,  hs.z),
-        center + glm::vec3(hs.x,  hs.y,  hs.z),
-        center + glm::vec3(-hs.x,  hs.y,  hs.z)
-    };
-    GLuint faceIndices[] = {
-        0,1,2, 0,2,3,
-        4,5,6, 4,6,7,
-        8,9,10, 8,10,11,
-    };
-    SimpleMesh m;
-    for (int i = 0; i < 8; i++) m.verts.push_back(v[i]);
-    for (int i = 0; i < 8; i++) m.cols.push_back(color);
-
-    GLuint idxs[] = {
-        0,1,2, 0,2,3,
-        4,5,6, 4,6,7,
-        0,4,7, 0,7,3,
-        1,5,6, 1,6,2,
-        3,2,6, 3,6,7,
-        0,1,5, 0,5,4
-    };
-    for (auto v : idxs) m.inds.push_back(v);
-    return m;
-}
-
-SimpleMesh make_textured_box(glm::vec3 center, glm::vec3 size) {
-    glm::vec3 hs = size * 0.5f;
-    glm::vec3 v[8] = {
-        center + glm::vec3(-hs.x, -hs.y, -hs.z), // 0
-        center + glm::vec3(hs.x, -hs.y, -hs.z),  // 1
-        center + glm::vec3(hs.x,  hs.y, -hs.z),  // 2
-        center + glm::vec3(-hs.x,  hs.y, -hs.z), // 3
-        center + glm::vec3(-hs.x, -hs.y,  hs.z), // 4
-        center + glm::vec3(hs.x, -hs.y,  hs.z),  // 5
-        center + glm::vec3(hs.x,  hs.y,  hs.z),  // 6
-        center + glm::vec3(-hs.x,  hs.y,  hs.z)  // 7
-    };
-
-    SimpleMesh m;
-
-    int faceVerts[6][4] = {
-        {0,1,2,3}, // back
-        {4,5,6,7}, // front  
-        {0,4,7,3}, // left
-        {1,5,6,2}, // right
-        {3,2,6,7}, // top
-        {0,1,5,4}  // bottom
-    };
-
-    glm::vec2 faceUVs[4] = {
-        glm::vec2(0.0f, 0.0f),  // нижний левый
-        glm::vec2(1.0f, 0.0f),  // нижний правый  
-        glm::vec2(1.0f, 1.0f),  // верхний правый
-        glm::vec2(0.0f, 1.0f)   // верхний левый
-    };
-
-    for (int f = 0; f < 6; f++) {
-        int base = m.verts.size();
-
-        m.verts.push_back(v[faceVerts[f][0]]);
-        m.verts.push_back(v[faceVerts[f][1]]);
-        m.verts.push_back(v[faceVerts[f][2]]);
-        m.verts.push_back(v[faceVerts[f][3]]);
-
-        m.uvs.push_back(faceUVs[0]);
-        m.uvs.push_back(faceUVs[1]);
-        m.uvs.push_back(faceUVs[2]);
-        m.uvs.push_back(faceUVs[3]);
-
-        for (int i = 0; i < 4; i++)
-            m.cols.push_back(glm::vec3(1.0f));
-
-        m.inds.push_back(base + 0);
-        m.inds.push_back(base + 1);
-        m.inds.push_back(base + 2);
-
-        m.inds.push_back(base + 0);
-        m.inds.push_back(base + 2);
-        m.inds.push_back(base + 3);
-    }
-
-    return m;
-}
-
-SimpleMesh make_cable(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, int segments, glm::vec3 color) {
-    SimpleMesh m;
-    for (int i = 0; i <= segments; i++) {
-        float t = (float)i / segments;
-        glm::vec3 p = (1 - t) * (1 - t) * p0 + 2 * (1 - t) * t * p1 + t * t * p2;
-        glm::vec3 tangent = glm::normalize(2 * (1 - t) * (p1 - p0) + 2 * t * (p2 - p1));
-        glm::vec3 up = glm::vec3(0, 1, 0);
-        glm::vec3 bit = glm::normalize(glm::cross(tangent, up));
-        float width = 0.015f;
-        glm::vec3 a = p - bit * width;
-        glm::vec3 b = p + bit * width;
-        m.verts.push_back(a);
-        m.verts.push_back(b);
-        m.cols.push_back(color);
-        m.cols.push_back(color);
-        if (i > 0) {
-            GLuint base = (GLuint)m.verts.size() - 4;
-            m.inds.push_back(base + 0);
-            m.inds.push_back(base + 1);
-            m.inds.push_back(base + 2);
-
-            m.inds.push_back(base + 1);
-            m.inds.push_back(base + 3);
-            m.inds.push_back(base + 2);
-        }
-    }
-    return m;
-}
-
-SimpleMesh make_colored_room() {
-    SimpleMesh m;
-
-    glm::vec3 center(0.0f);
-    glm::vec3 size(6.0f, 4.0f, 6.0f);
-    glm::vec3 hs = size * 0.5f;
-
-    glm::vec3 v[8] = {
-        center + glm::vec3(-hs.x, -hs.y, -hs.z), // 0
-        center + glm::vec3(hs.x, -hs.y, -hs.z),  // 1
-        center + glm::vec3(hs.x,  hs.y, -hs.z),  // 2
-        center + glm::vec3(-hs.x,  hs.y, -hs.z), // 3
-
-        center + glm::vec3(-hs.x, -hs.y,  hs.z), // 4
-        center + glm::vec3(hs.x, -hs.y,  hs.z),  // 5
-        center + glm::vec3(hs.x,  hs.y,  hs.z),  // 6
-        center + glm::vec3(-hs.x,  hs.y,  hs.z)  // 7
-    };
-
-    int faceVerts[6][4] = {
-        {0,1,2,3},
-        {4,5,6,7},
-        {0,4,7,3},
-        {1,5,6,2},
-        {3,2,6,7},
-        {0,1,5,4} 
-    };
-
-    glm::vec3 colors[6] = {
-        glm::vec3(0.94f, 0.90f, 0.75f),  
-        glm::vec3(0.94f, 0.90f, 0.75f),  
-        glm::vec3(0.94f, 0.90f, 0.82f),  
-        glm::vec3(0.94f, 0.90f, 0.82f),  
-        glm::vec3(1.0f, 0.97f, 0.70f),
-        glm::vec3(0.45f, 0.30f, 0.18f) 
-    };
-
-    for (int f = 0; f < 6; f++) {
-        int base = m.verts.size();
-
-        m.verts.push_back(v[faceVerts[f][0]]);
-        m.verts.push_back(v[faceVerts[f][1]]);
-        m.verts.push_back(v[faceVerts[f][2]]);
-        m.verts.push_back(v[faceVerts[f][3]]);
-
-        for (int i = 0; i < 4; i++)
-            m.cols.push_back(colors[f]);
-
-        m.inds.push_back(base + 0);
-        m.inds.push_back(base + 1);
-        m.inds.push_back(base + 2);
-
-        m.inds.push_back(base + 0);
-        m.inds.push_back(base + 2);
-        m.inds.push_back(base + 3);
-    }
-
-    return m;
-}
-
-
-
 int main()
 {
     GLFWwindow* window = InitAll(1024, 768, false);
@@ -217,221 +35,249 @@ int main()
     glClearColor(0.85f, 0.9f, 0.95f, 1.0f);
 
 
-    GLuint phone_texture_id;
-
-    // Загрузка текстуры
-    glGenTextures(1, &phone_texture_id);
-    glBindTexture(GL_TEXTURE_2D, phone_texture_id);
-
-    // Загрузка изображения stb_image
-    int width, height, channels;
-    unsigned char* image_data = stbi_load("phone.png", &width, &height, &channels, 3);
-    if (image_data) {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image_data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-        stbi_image_free(image_data);
-    }
-    else {
-        std::cout << "Failed to load texture" << std::endl;
+    // Объекты, их сетки, материалы и расположение описаны в scene.txt.
+    // Текстуры и исходники моделей догружаются в фоне, до готовности
+    // рисуются заглушки и сгенерированные сетки.
+    TextureManager textures;
+    MeshImporter importer;
+    JobSystem jobs;
+    Scene scene;
+    if (!scene.load("scene.txt", window, textures, importer, jobs)) {
+        jobs.shutdown();
+        importer.shutdown();
+        textures.shutdown();
+        EndAll();
+        return -1;
     }
 
+    // камера управление
+    struct CameraState {
+        glm::vec3 pos;
+        float yaw, pitch;
+    };
+    CameraState cam = { scene.camera_position, scene.camera_yaw, scene.camera_pitch };
+    CameraState prevCam = cam;
+
+    // Симуляция (камера, стол, опоры) идёт постоянными шагами, кадр рисует
+    // состояние между двумя последними шагами.
+    FixedTimestep clock(1.0 / 120.0);
+    string window_title = "Phone Charging Scene";
+
+    // Перетаскивание мышью: объект под курсором едет по горизонтальной
+    // плоскости, проходящей через точку попадания. Сдвиг копится между
+    // кадрами и применяется в ближайшем шаге симуляции.
+    int dragged = -1;
+    glm::vec3 drag_point(0.0f);
+    glm::vec3 drag_move(0.0f);
+    bool mouse_was_down = false;
+    double pick_ms = 0.0;
+
+    // Ввод опрашивается в главном потоке (GLFW) и передаётся подготовке
+    // кадра снимком.
+    struct InputState {
+        double now = 0.0;
+        bool key[GLFW_KEY_LAST + 1] = {};
+        bool mouse_down = false;
+        double cursor_x = 0.0, cursor_y = 0.0;
+        int width = 0, height = 0;
+    };
+    auto read_input = [&](InputState& in) {
+        in.now = glfwGetTime();
+        for (int k : { GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_D, GLFW_KEY_Q, GLFW_KEY_E,
+                       GLFW_KEY_I, GLFW_KEY_K, GLFW_KEY_J, GLFW_KEY_L,
+                       GLFW_KEY_LEFT, GLFW_KEY_RIGHT, GLFW_KEY_UP, GLFW_KEY_DOWN })
+            in.key[k] = glfwGetKey(window, k) == GLFW_PRESS;
+        in.mouse_down = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+        glfwGetCursorPos(window, &in.cursor_x, &in.cursor_y);
+        in.width = WinWidth;
+        in.height = WinHeight;
+    };
 
-    Model room(window);
-    Model phone(window);
-    Model plug(window);
-    Model cable(window);
-    Model table(window);
-    glm::vec3 table_pos(0.0f, -0.6f, 0.0f);
-
-    float table_hx = 2.0f * 0.5f;
-    float table_hz = 1.0f * 0.5f;
-    float table_y_bottom = -0.6f - 0.1f; 
-
-    float leg_width = 0.08f;
-    float leg_height = 0.7f;
-    float leg_half = leg_width * 0.5f;
-    float inset_margin = 0.02f;
-
-    float px = table_hx - leg_half - inset_margin;
-    float pz = table_hz - leg_half - inset_margin;
-
-    float leg_center_y = table_y_bottom - leg_height * 0.5f;
-
-    auto make_leg = [&](float x, float z) {
-        return make_box(
-            glm::vec3(x, leg_center_y, z),  
-            glm::vec3(leg_width, leg_height, leg_width),
-            glm::vec3(0.35f, 0.18f, 0.08f)
-        );
-        };
-
-    SimpleMesh L1 = make_leg(0.0f + px, 0.0f + pz);  // правая передняя
-    SimpleMesh L2 = make_leg(0.0f + px, 0.0f - pz);  // правая задняя
-    SimpleMesh L3 = make_leg(0.0f - px, 0.0f + pz);  // левая передняя
-    SimpleMesh L4 = make_leg(0.0f - px, 0.0f - pz);  // левая задняя
-
-    Model leg1(window);
-    leg1.load_coords(L1.verts.data(), L1.verts.size());
-    leg1.load_colors(L1.cols.data(), L1.cols.size());
-    leg1.load_indices(L1.inds.data(), L1.inds.size());
-    Model leg2(window);
-    leg2.load_coords(L2.verts.data(), L2.verts.size());
-    leg2.load_colors(L2.cols.data(), L2.cols.size());
-    leg2.load_indices(L2.inds.data(), L2.inds.size());
-    Model leg3(window);
-    leg3.load_coords(L3.verts.data(), L3.verts.size());
-    leg3.load_colors(L3.cols.data(), L3.cols.size());
-    leg3.load_indices(L3.inds.data(), L3.inds.size());
-    Model leg4(window);
-    leg4.load_coords(L4.verts.data(), L4.verts.size());
-    leg4.load_colors(L4.cols.data(), L4.cols.size());
-    leg4.load_indices(L4.inds.data(), L4.inds.size());
-
-    room.load_shaders("vs.glsl", "fs.glsl");
-    table.load_shaders("vs.glsl", "fs.glsl");
-    phone.load_shaders("vs_phone.glsl", "fs_phone.glsl");
-    plug.load_shaders("vs.glsl", "fs.glsl");
-    cable.load_shaders("vs.glsl", "fsCable.glsl");
-
-    SimpleMesh roomMesh = make_colored_room();
-    room.load_coords(roomMesh.verts.data(), roomMesh.verts.size());
-    room.load_colors(roomMesh.cols.data(), roomMesh.cols.size());
-    room.load_indices(roomMesh.inds.data(), roomMesh.inds.size());
-
-    SimpleMesh tableMesh = make_box(table_pos, glm::vec3(2.0f, 0.2f, 1.0f), glm::vec3(0.6f, 0.3f, 0.1f));
-    table.load_coords(tableMesh.verts.data(), tableMesh.verts.size());
-    table.load_colors(tableMesh.cols.data(), tableMesh.cols.size());
-    table.load_indices(tableMesh.inds.data(), tableMesh.inds.size());
-
-    glm::vec3 phone_pos = glm::vec3(0.3f, -1.09f, 0.0f);
-
-    glm::vec3 phone_local_offset = glm::vec3(-0.3f, -1.09f, 0.0f);
-
-    SimpleMesh phoneMesh = make_textured_box(phone_pos, glm::vec3(0.2f, 0.02f, 0.12f));
-    phone.load_coords(phoneMesh.verts.data(), phoneMesh.verts.size());
-    phone.load_colors(phoneMesh.cols.data(), phoneMesh.cols.size());
-    phone.load_uvs(phoneMesh.uvs.data(), phoneMesh.uvs.size());
-    phone.load_indices(phoneMesh.inds.data(), phoneMesh.inds.size());
-
-    float phone_half_x = 0.1f;   // половина ширины телефона
-    float phone_half_z = 0.06f;  // половина глубины телефона
-    float max_table_x = table_hx - phone_local_offset.x - phone_half_x;   // когда правый край телефона упирается в правый край стола
-    float min_table_x = -table_hx - phone_local_offset.x + phone_half_x;  // когда левый край телефона упирается в левый край стола
-    float max_table_z = table_hz - phone_local_offset.z - phone_half_z;
-    float min_table_z = -table_hz - phone_local_offset.z + phone_half_z;
-
-    SimpleMesh plugMesh = make_box(glm::vec3(2.98f, -0.2f, 0.0f), glm::vec3(0.08f, 0.06f, 0.04f), glm::vec3(0.15f, 0.15f, 0.15f)); 
-    plug.load_coords(plugMesh.verts.data(), plugMesh.verts.size());
-    plug.load_colors(plugMesh.cols.data(), plugMesh.cols.size());
-    plug.load_indices(plugMesh.inds.data(), plugMesh.inds.size());
-
-    glm::vec3 p0 = glm::vec3(2.96f, -0.2f, 0.0f);
-    glm::vec3 p1 = glm::vec3(1.8f, -1.0f, 0.0f);
-    glm::vec3 p2 = glm::vec3(0.38f, -1.1f, 0.0f);
-    SimpleMesh cableMesh = make_cable(p0, p1, p2, 48, glm::vec3(0.1f, 0.1f, 0.1f));
-    cable.load_coords(cableMesh.verts.data(), cableMesh.verts.size());
-    cable.load_colors(cableMesh.cols.data(), cableMesh.cols.size());
-    cable.load_indices(cableMesh.inds.data(), cableMesh.inds.size());
+    // Кадры идут конвейером: пока главный поток отправляет в GL кадр N,
+    // задача в пуле считает для кадра N + 1 симуляцию, выбор мышью,
+    // вершины кабелей и список рисования. Всё, что нужно для отправки,
+    // лежит в наборе кадра. Клавиши 1-3 задают, сколько кадров может
+    // быть в полёте: при 1 конвейер выключается, и ввод снимается только
+    // после того, как GPU дорисовал предыдущий кадр.
+    struct FrameData {
+        RenderList draws;
+        vector<vector<glm::vec3>> ropes;
+        double time = 0.0;      // снятие ввода
+        int width = 0, height = 0;
+        string status;          // для заголовка окна
+        bool ready = false;
+    };
+    const int FRAMES_IN_FLIGHT = 3;
+    FrameData frames[FRAMES_IN_FLIGHT];
+    FrameFences fences(FRAMES_IN_FLIGHT);
+    fences.set_max_in_flight(2);
+    string latency_text;
+    double latency_shown = 0.0;
+
+    auto prepare_frame = [&](const InputState& in, FrameData& f) {
+        int ticks = clock.advance(in.now);
+        for (int t = 0; t < ticks; t++) {
+            prevCam = cam;
+            scene.begin_tick();
+            float dt = (float)clock.step();
+
+            float speed = 2.0f;
+            glm::vec3 forward(
+                sin(glm::radians(cam.yaw)),
+                0,
+                -cos(glm::radians(cam.yaw))
+            );
+            glm::vec3 right = glm::normalize(glm::cross(forward, glm::vec3(0, 1, 0)));
+
+            if (in.key[GLFW_KEY_W]) cam.pos += forward * speed * dt;
+            if (in.key[GLFW_KEY_S]) cam.pos -= forward * speed * dt;
+            if (in.key[GLFW_KEY_A]) cam.pos -= right * speed * dt;
+            if (in.key[GLFW_KEY_D]) cam.pos += right * speed * dt;
+            if (in.key[GLFW_KEY_Q]) cam.pos.y += speed * dt;
+            if (in.key[GLFW_KEY_E]) cam.pos.y -= speed * dt;
+
+            glm::vec3 move(0.0f);
+            if (in.key[GLFW_KEY_I]) move.z += speed * dt;
+            if (in.key[GLFW_KEY_K]) move.z -= speed * dt;
+            if (in.key[GLFW_KEY_J]) move.x -= speed * dt;
+            if (in.key[GLFW_KEY_L]) move.x += speed * dt;
+            scene.move_controlled(move);
+            if (dragged >= 0) scene.drag(dragged, drag_move);
+            drag_move = glm::vec3(0.0f);
+            scene.update_transforms();
+            scene.simulate(dt);
+
+            if (in.key[GLFW_KEY_LEFT]) cam.yaw += 60.0f * dt;
+            if (in.key[GLFW_KEY_RIGHT]) cam.yaw -= 60.0f * dt;
+            if (in.key[GLFW_KEY_UP]) cam.pitch += 40.0f * dt;
+            if (in.key[GLFW_KEY_DOWN]) cam.pitch -= 40.0f * dt;
+
+            if (cam.pitch > 89.0f) cam.pitch = 89.0f;
+            if (cam.pitch < -89.0f) cam.pitch = -89.0f;
+        }
 
-    // камера управление
-    glm::vec3 camPos = glm::vec3(-2.0f, 0.0f, 3.0f);
-    float camYaw = 40.0f;
-    float camPitch = -10.0f;
-
-    float lastTime = (float)glfwGetTime();
-    while (!glfwWindowShouldClose(window)) {
-        float now = (float)glfwGetTime();
-        float dt = now - lastTime;
-        lastTime = now;
-
-        float speed = 2.0f;
-        glm::vec3 forward(
-            sin(glm::radians(camYaw)),
-            0,
-            -cos(glm::radians(camYaw))
-        );
-        glm::vec3 right = glm::normalize(glm::cross(forward, glm::vec3(0, 1, 0)));
-
-        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) camPos += forward * speed * dt;
-        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) camPos -= forward * speed * dt;
-        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) camPos -= right * speed * dt;
-        if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) camPos += right * speed * dt;
-        if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS) camPos.y += speed * dt;
-        if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS) camPos.y -= speed * dt;
-
-        if (glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS) table_pos.z += speed * dt; 
-        if (glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS) table_pos.z -= speed * dt;  
-        if (glfwGetKey(window, GLFW_KEY_J) == GLFW_PRESS) table_pos.x -= speed * dt; 
-        if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS) table_pos.x += speed * dt; 
-
-
-        if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) camYaw += 60.0f * dt;
-        if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) camYaw -= 60.0f * dt;
-        if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) camPitch += 40.0f * dt;
-        if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) camPitch -= 40.0f * dt;
-
-        if (camPitch > 89.0f) camPitch = 89.0f;
-        if (camPitch < -89.0f) camPitch = -89.0f;
+        float alpha = clock.alpha();
+        glm::vec3 camPos = glm::mix(prevCam.pos, cam.pos, alpha);
+        float camYaw = glm::mix(prevCam.yaw, cam.yaw, alpha);
+        float camPitch = glm::mix(prevCam.pitch, cam.pitch, alpha);
 
         glm::mat4 view = glm::lookAt(camPos,
             camPos + glm::vec3(sin(glm::radians(camYaw)) * cos(glm::radians(camPitch)),
                 sin(glm::radians(camPitch)),
                 -cos(glm::radians(camYaw)) * cos(glm::radians(camPitch))),
             glm::vec3(0, 1, 0));
-        glm::mat4 projection = glm::perspective(glm::radians(60.0f), (float)WinWidth / (float)WinHeight, 0.1f, 100.0f);
-
-        glViewport(0, 0, WinWidth, WinHeight);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        auto renderModel = [&](Model& m, glm::mat4 modelMat) {
-            glm::mat4 MVP = projection * view * modelMat;
-            GLuint prog = m.get_shader_programme();
-            glUseProgram(prog);
-            GLint id = glGetUniformLocation(prog, "MVP");
-            if (id >= 0) glUniformMatrix4fv(id, 1, GL_FALSE, glm::value_ptr(MVP));
-            GLint id2 = glGetUniformLocation(prog, "ModelMat");
-            if (id2 >= 0) glUniformMatrix4fv(id2, 1, GL_FALSE, glm::value_ptr(modelMat));
-            GLint tid = glGetUniformLocation(prog, "u_time");
-            if (tid >= 0) glUniform1f(tid, now);
-
-
-            if (&m == &phone) {
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, phone_texture_id);
-                GLint texLoc = glGetUniformLocation(prog, "tex");
-                if (texLoc >= 0) glUniform1i(texLoc, 0);
+        glm::mat4 projection = glm::perspective(glm::radians(60.0f), (float)in.width / (float)in.height, 0.1f, 100.0f);
+
+        // луч из камеры через курсор: точки на ближней и дальней плоскостях
+        if (!in.mouse_down) dragged = -1;
+        else if (in.width > 0 && in.height > 0) {
+            float nx = (float)(2.0 * in.cursor_x / in.width - 1.0);
+            float ny = (float)(1.0 - 2.0 * in.cursor_y / in.height);
+            glm::mat4 unproject = glm::inverse(projection * view);
+            glm::vec4 near_pt = unproject * glm::vec4(nx, ny, -1.0f, 1.0f);
+            glm::vec4 far_pt = unproject * glm::vec4(nx, ny, 1.0f, 1.0f);
+            glm::vec3 origin = glm::vec3(near_pt) / near_pt.w;
+            glm::vec3 dir = glm::vec3(far_pt) / far_pt.w - origin; // t = 1 - дальняя плоскость
+
+            if (!mouse_was_down) {
+                auto start = std::chrono::steady_clock::now();
+                float t = 0.0f;
+                int hit = scene.pick(origin, dir, 1.0f, &t);
+                pick_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                dragged = hit >= 0 ? scene.drag_handle(hit) : -1;
+                if (hit >= 0) drag_point = origin + dir * t;
             }
+            else if (dragged >= 0 && std::fabs(dir.y) > 1e-6f) {
+                float s = (drag_point.y - origin.y) / dir.y;
+                if (s > 0.0f && s <= 1.0f) {
+                    glm::vec3 p = origin + dir * s;
+                    drag_move += p - drag_point;
+                    drag_point = p;
+                }
+            }
+        }
+        mouse_was_down = in.mouse_down;
 
-            m.render(GL_TRIANGLES);
-        };
-
-        renderModel(room, glm::translate(glm::mat4(1.0f), glm::vec3(0)));
-        renderModel(phone, glm::mat4(1.0f));
-        renderModel(plug, glm::mat4(1.0f));
-        renderModel(cable, glm::mat4(1.0f));
+        f.status.clear();
+        if (dragged >= 0) {
+            char pick_time[32];
+            snprintf(pick_time, sizeof(pick_time), "%.3f ms", pick_ms);
+            f.status = " - dragging " + scene.objects[dragged].name + ", picked in " + pick_time;
+        }
 
-        if (table_pos.x > max_table_x) table_pos.x = max_table_x;
-        if (table_pos.x < min_table_x) table_pos.x = min_table_x;
-        if (table_pos.z > max_table_z) table_pos.z = max_table_z;
-        if (table_pos.z < min_table_z) table_pos.z = min_table_z;
+        scene.build_ropes(alpha, f.ropes);
+        f.draws.build(scene, view, projection, alpha, jobs);
+        f.time = in.now;
+        f.width = in.width;
+        f.height = in.height;
+        f.ready = true;
+    };
 
-        renderModel(table, glm::translate(glm::mat4(1.0f), table_pos));
+    InputState input;
+    clock.reset(glfwGetTime());
+    for (uint64_t frame = 0; !glfwWindowShouldClose(window); frame++) {
+        int slot = (int)(frame % FRAMES_IN_FLIGHT);
+        FrameData& current = frames[slot];
+        FrameData& next = frames[(frame + 1) % FRAMES_IN_FLIGHT];
+
+        // Подготовка ещё не запущена, поэтому сцену можно менять: готовые
+        // текстуры и импортированные модели подменяются здесь.
+        textures.update(2.0);
+        importer.poll();
+
+        // ход импорта виден в заголовке окна, C отменяет загрузку моделей
+        if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS) importer.cancel_all();
+        for (int n = 1; n <= FRAMES_IN_FLIGHT; n++)
+            if (glfwGetKey(window, GLFW_KEY_1 + n - 1) == GLFW_PRESS) fences.set_max_in_flight(n);
+        double avg_latency, max_latency;
+        if (glfwGetTime() - latency_shown >= 0.5 && fences.take_latency(&avg_latency, &max_latency)) {
+            char text[96];
+            snprintf(text, sizeof(text), " - %d frame(s) in flight (1-%d), input latency %.1f ms (max %.1f)",
+                fences.max_in_flight(), FRAMES_IN_FLIGHT, avg_latency, max_latency);
+            latency_text = text;
+            latency_shown = glfwGetTime();
+        }
+        int importing = 0;
+        float import_progress = importer.progress(&importing);
+        string title = "Phone Charging Scene";
+        if (importing)
+            title += " - loading " + to_string(importing) + " model(s) " + to_string((int)(import_progress * 100.0f)) + "%, C to cancel";
+        title += latency_text + current.status;
+        if (title != window_title) {
+            glfwSetWindowTitle(window, title.c_str());
+            window_title = title;
+        }
 
-        float px = table_hx - leg_half - inset_margin;
-        float pz = table_hz - leg_half - inset_margin;
-        float leg_center_y = table_pos.y - 0.1f - leg_height * 0.5f;
+        // без конвейера (и на первом кадре после его включения) кадр готовится здесь же
+        read_input(input);
+        if (!current.ready) prepare_frame(input, current);
+        if (fences.max_in_flight() > 1) jobs.add("prepare frame", [&] { prepare_frame(input, next); });
 
-        renderModel(leg1, glm::translate(glm::mat4(1.0f), glm::vec3(table_pos.x + px, leg_center_y, table_pos.z + pz)));
-        renderModel(leg2, glm::translate(glm::mat4(1.0f), glm::vec3(table_pos.x + px, leg_center_y, table_pos.z - pz)));
-        renderModel(leg3, glm::translate(glm::mat4(1.0f), glm::vec3(table_pos.x - px, leg_center_y, table_pos.z + pz)));
-        renderModel(leg4, glm::translate(glm::mat4(1.0f), glm::vec3(table_pos.x - px, leg_center_y, table_pos.z - pz)));
+        // GL вызывается только отсюда
+        glViewport(0, 0, current.width, current.height);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        scene.stream_ropes(current.ropes);
+        current.draws.submit((float)current.time, glm::vec2((float)current.width, (float)current.height));
+        current.ready = false;
 
         glfwPollEvents();
         glfwSwapBuffers(window);
+        fences.signal(frame, current.time);
+        fences.limit(frame);
+        jobs.wait();
+        jobs.forget();
 
         if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) glfwSetWindowShouldClose(window, 1);
     }
-
+    fences.release();
+
+    std::cout << "Job system:" << std::endl;
+    jobs.stats(std::cout);
+    jobs.shutdown();
+    importer.shutdown();
+    textures.shutdown();
+    SamplerCache::instance().clear();
+    ShaderCache::instance().clear();
     EndAll();
     return 0;
 }
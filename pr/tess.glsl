@@ -0,0 +1,87 @@
+#version 400
+// Tessellation stages for cables (SHADER_TESSELLATED). A patch is four
+// consecutive control points; the segment between the middle two is
+// expanded into a flat ribbon along a Catmull-Rom spline.
+
+uniform mat4 MVP;
+uniform mat4 ModelMat;
+
+#ifdef TESS_CONTROL_SHADER
+layout(vertices = 4) out;
+
+#ifdef VERTEX_COLOR
+in vec3 color[];
+out vec3 tc_color[];
+#endif
+
+uniform vec2 u_viewport = vec2(1024.0, 768.0);
+uniform float u_segment_pixels = 8.0; // target on-screen length of one subdivision
+
+void main()
+{
+    gl_out[gl_InvocationID].gl_Position = gl_in[gl_InvocationID].gl_Position;
+#ifdef VERTEX_COLOR
+    tc_color[gl_InvocationID] = color[gl_InvocationID];
+#endif
+    if (gl_InvocationID != 0) return;
+
+    vec4 a = MVP * gl_in[1].gl_Position;
+    vec4 b = MVP * gl_in[2].gl_Position;
+    float levels = 0.0; // segment entirely behind the camera is dropped
+    if (a.w > 0.0 || b.w > 0.0) {
+        vec2 sa = a.xy / max(a.w, 1e-3) * 0.5 * u_viewport;
+        vec2 sb = b.xy / max(b.w, 1e-3) * 0.5 * u_viewport;
+        levels = clamp(ceil(length(sb - sa) / u_segment_pixels), 1.0, 64.0);
+    }
+    // quads: u runs along the cable, v across it
+    gl_TessLevelOuter[0] = levels > 0.0 ? 1.0 : 0.0;
+    gl_TessLevelOuter[1] = levels;
+    gl_TessLevelOuter[2] = levels > 0.0 ? 1.0 : 0.0;
+    gl_TessLevelOuter[3] = levels;
+    gl_TessLevelInner[0] = levels;
+    gl_TessLevelInner[1] = 1.0;
+}
+#endif
+
+#ifdef TESS_EVALUATION_SHADER
+#include "common.glsl"
+
+layout(quads, equal_spacing, ccw) in;
+
+#ifdef VERTEX_COLOR
+in vec3 tc_color[];
+#endif
+
+uniform float u_half_width = 0.015;
+
+void main()
+{
+    float t = gl_TessCoord.x;
+    vec3 p0 = gl_in[0].gl_Position.xyz;
+    vec3 p1 = gl_in[1].gl_Position.xyz;
+    vec3 p2 = gl_in[2].gl_Position.xyz;
+    vec3 p3 = gl_in[3].gl_Position.xyz;
+
+    vec3 c1 = p2 - p0;
+    vec3 c2 = 2.0 * p0 - 5.0 * p1 + 4.0 * p2 - p3;
+    vec3 c3 = 3.0 * (p1 - p2) + p3 - p0;
+    vec3 pos = p1 + 0.5 * t * (c1 + t * (c2 + t * c3));
+    vec3 tangent = c1 + t * (2.0 * c2 + 3.0 * t * c3);
+
+    vec3 side = cross(tangent, vec3(0.0, 1.0, 0.0));
+    float len = length(side);
+    side = len > 1e-6 ? side / len : vec3(1.0, 0.0, 0.0);
+    pos += side * (gl_TessCoord.y * 2.0 - 1.0) * u_half_width;
+
+#ifdef VERTEX_COLOR
+    color = mix(tc_color[1], tc_color[2], t);
+#endif
+#ifdef TEXTURED
+    uv = gl_TessCoord.xy;
+#endif
+#ifdef STRIPES
+    world_pos = (ModelMat * vec4(pos, 1.0)).xyz;
+#endif
+    gl_Position = MVP * vec4(pos, 1.0);
+}
+#endif
@@ -1,17 +1,32 @@
 #version 400
+#include "common.glsl"
 
 layout(location = 0) in vec3 vertex_position;
+#ifdef VERTEX_COLOR
 layout(location = 1) in vec3 vertex_color;
-
-out vec3 color;
-out vec3 world_pos;
+#endif
+#ifdef TEXTURED
+layout(location = 2) in vec2 vertex_uv;
+#endif
 
 uniform mat4 MVP;
 uniform mat4 ModelMat;
 
 void main()
 {
+#ifdef VERTEX_COLOR
     color = vertex_color;
+#endif
+#ifdef TEXTURED
+    uv = vertex_uv;
+#endif
+#ifdef TESSELLATED
+    // cable control point, transformed by tess.glsl
+    gl_Position = vec4(vertex_position, 1.0);
+#else
+#ifdef STRIPES
     world_pos = (ModelMat * vec4(vertex_position, 1.0)).xyz;
+#endif
     gl_Position = MVP * vec4(vertex_position, 1.0);
+#endif
 }
@@ -0,0 +1,154 @@
+﻿// bake.cpp - офлайн подготовка ресурсов для pr.
+//
+//   bake texture <in.png> <out.ctex> [bc1|bc3|bc7]
+//   bake mesh <in.obj|in.fbx|...> <out.mesh>
+//   bake pack [-z] <out.pack> <root> <files...>
+//
+// Без явного формата непрозрачные изображения сжимаются в BC1, с
+// прозрачностью - в BC3. Модели импортируются через Assimp так же, как в
+// MeshImporter, и сохраняются в .mesh для загрузки без разбора. Архив
+// собирается из файлов, заданных относительно root (под этими именами их
+// ищет LoadAsset); с -z записи сжимаются LZ4, если это даёт выигрыш.
+#include "TextureCodec.h"
+#include "MeshFile.h"
+#include "MeshImporter.h"
+#include "AssetPack.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb-master/stb_image.h"
+
+using namespace std;
+
+static bool read_file(const string& path, vector<unsigned char>& data) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    data.resize(size > 0 ? (size_t)size : 0);
+    bool ok = size >= 0 && fread(data.data(), 1, data.size(), f) == data.size();
+    fclose(f);
+    return ok;
+}
+
+static bool write_file(const char* path, const vector<unsigned char>& data) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+    fclose(f);
+    return ok;
+}
+
+static int bake_texture(int argc, char** argv) {
+    if (argc < 4) {
+        fprintf(stderr, "usage: bake texture <in.png> <out.ctex> [bc1|bc3|bc7]\n");
+        return 1;
+    }
+    int w, h, channels;
+    unsigned char* rgba = stbi_load(argv[2], &w, &h, &channels, 4);
+    if (!rgba) {
+        fprintf(stderr, "bake: cannot load %s: %s\n", argv[2], stbi_failure_reason());
+        return 1;
+    }
+
+    uint32_t format = CTEX_BC1;
+    if (argc > 4) {
+        if (!strcmp(argv[4], "bc1")) format = CTEX_BC1;
+        else if (!strcmp(argv[4], "bc3")) format = CTEX_BC3;
+        else if (!strcmp(argv[4], "bc7")) format = CTEX_BC7;
+        else {
+            fprintf(stderr, "bake: unknown format %s\n", argv[4]);
+            stbi_image_free(rgba);
+            return 1;
+        }
+    }
+    else {
+        for (size_t i = 0; i < (size_t)w * h; i++)
+            if (rgba[i * 4 + 3] != 255) { format = CTEX_BC3; break; }
+    }
+
+    vector<unsigned char> out = BakeCtex(rgba, w, h, format);
+    stbi_image_free(rgba);
+    if (!write_file(argv[3], out)) {
+        fprintf(stderr, "bake: cannot write %s\n", argv[3]);
+        return 1;
+    }
+    printf("%s: %dx%d -> %zu bytes (%.1fx smaller than RGBA8 with mips)\n", argv[3], w, h, out.size(),
+        (double)w * h * 4 * 4 / 3 / out.size());
+    return 0;
+}
+
+static int bake_mesh(int argc, char** argv) {
+    if (argc < 4) {
+        fprintf(stderr, "usage: bake mesh <in> <out.mesh>\n");
+        return 1;
+    }
+    ImportResult imported = MeshImporter::load(argv[2]);
+    if (!imported.ok) {
+        fprintf(stderr, "bake: cannot import %s: %s\n", argv[2], imported.error.c_str());
+        return 1;
+    }
+
+    vector<unsigned char> out = BakeMeshFile(imported.mesh);
+    if (!write_file(argv[3], out)) {
+        fprintf(stderr, "bake: cannot write %s\n", argv[3]);
+        return 1;
+    }
+    printf("%s: %zu vertices, %zu triangles -> %zu bytes\n", argv[3], imported.mesh.verts.size(),
+        imported.mesh.inds.size() / 3, out.size());
+    return 0;
+}
+
+static int bake_pack(int argc, char** argv) {
+    int arg = 2;
+    bool compress = false;
+    if (arg < argc && !strcmp(argv[arg], "-z")) {
+        compress = true;
+        arg++;
+    }
+    if (argc - arg < 3) {
+        fprintf(stderr, "usage: bake pack [-z] <out.pack> <root> <files...>\n");
+        return 1;
+    }
+    const char* out_path = argv[arg++];
+    string root = argv[arg++];
+    if (!root.empty() && root.back() != '/' && root.back() != '\\') root += '/';
+
+    vector<PackInput> inputs;
+    size_t raw_total = 0;
+    for (; arg < argc; arg++) {
+        PackInput in;
+        in.name = argv[arg];
+        for (char& c : in.name) if (c == '\\') c = '/';
+        in.compress = compress;
+        if (!read_file(root + in.name, in.data)) {
+            fprintf(stderr, "bake: cannot read %s\n", (root + in.name).c_str());
+            return 1;
+        }
+        raw_total += in.data.size();
+        inputs.push_back(std::move(in));
+    }
+
+    size_t count = inputs.size();
+    vector<unsigned char> out = BuildAssetPack(std::move(inputs));
+    if (!write_file(out_path, out)) {
+        fprintf(stderr, "bake: cannot write %s\n", out_path);
+        return 1;
+    }
+    printf("%s: %zu entries, %zu bytes -> %zu bytes\n", out_path, count, raw_total, out.size());
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && !strcmp(argv[1], "texture")) return bake_texture(argc, argv);
+    if (argc > 1 && !strcmp(argv[1], "mesh")) return bake_mesh(argc, argv);
+    if (argc > 1 && !strcmp(argv[1], "pack")) return bake_pack(argc, argv);
+    fprintf(stderr, "usage: bake texture <in.png> <out.ctex> [bc1|bc3|bc7]\n"
+        "       bake mesh <in> <out.mesh>\n"
+        "       bake pack [-z] <out.pack> <root> <files...>\n");
+    return 1;
+}
@@ -0,0 +1,219 @@
+﻿// bench.cpp - замеры структур pr на синтетических данных, без окна и GL.
+//
+//   bench [all|bvh|rope|tube|pick] [N]
+//
+// bvh  - AabbTree для N объектов (по умолчанию 10k, 30k и 100k) против
+//        перебора: построение, луч, отсечение пирамидой видимости; ответы
+//        дерева сверяются с перебором.
+// rope - шаг 1 мс для 300 верёвок по 49 частиц (Verlet, RopeSystem).
+// tube - развёртка трубки по 256 точкам и 16 вершинам сечения (TubeSweep).
+// pick - луч против сферы из 50k треугольников (PickMesh).
+//
+// Собирать в Release: в Debug цифры ничего не говорят о кадре.
+#include "AabbTree.h"
+#include "Rope.h"
+#include "Tube.h"
+#include "PickMesh.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static double elapsed_us(Clock::time_point start) {
+    return chrono::duration<double, micro>(Clock::now() - start).count();
+}
+
+// тот же тест, что в query_frustum, но без обхода дерева
+static bool in_frustum(const glm::mat4& vp, const Aabb& box) {
+    glm::vec3 c = (box.lo + box.hi) * 0.5f, e = (box.hi - box.lo) * 0.5f;
+    for (int k = 0; k < 3; k++) {
+        for (int sign = -1; sign <= 1; sign += 2) {
+            glm::vec4 p(vp[0][3] + sign * vp[0][k], vp[1][3] + sign * vp[1][k],
+                vp[2][3] + sign * vp[2][k], vp[3][3] + sign * vp[3][k]);
+            float d = p.x * c.x + p.y * c.y + p.z * c.z + p.w;
+            float r = fabs(p.x) * e.x + fabs(p.y) * e.y + fabs(p.z) * e.z;
+            if (d + r < 0.0f) return false;
+        }
+    }
+    return true;
+}
+
+static bool bench_bvh(int count) {
+    mt19937 rng(1);
+    uniform_real_distribution<float> unit(0.0f, 1.0f);
+    // плотность не зависит от числа объектов
+    float world = cbrt((float)count) * 2.0f;
+    auto random_point = [&] { return glm::vec3(unit(rng), unit(rng), unit(rng)) * world; };
+
+    vector<Aabb> boxes(count);
+    for (Aabb& b : boxes) {
+        glm::vec3 c = random_point();
+        glm::vec3 half(0.1f + unit(rng) * 0.4f);
+        b.lo = c - half;
+        b.hi = c + half;
+    }
+
+    AabbTree tree;
+    vector<AabbTree::Proxy> proxies(count);
+    auto start = Clock::now();
+    for (int i = 0; i < count; i++) proxies[i] = tree.insert(boxes[i], i);
+    double build_us = elapsed_us(start);
+    bool ok = true;
+
+    // лучи: дерево против перебора всех коробок
+    const int rays = 2000, brute_rays = 100;
+    vector<glm::vec3> origins(rays), dirs(rays);
+    for (int k = 0; k < rays; k++) {
+        origins[k] = random_point();
+        dirs[k] = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) - 0.5f);
+    }
+    vector<int> tree_hit(rays);
+    vector<float> tree_t(rays);
+    start = Clock::now();
+    for (int k = 0; k < rays; k++) {
+        glm::vec3 inv = 1.0f / dirs[k];
+        tree_hit[k] = tree.ray_cast(origins[k], dirs[k], world, [&](int user) {
+            float t;
+            return ray_aabb(origins[k], inv, boxes[user], world, &t) ? t : -1.0f;
+        }, &tree_t[k]);
+    }
+    double ray_us = elapsed_us(start) / rays;
+    start = Clock::now();
+    for (int k = 0; k < brute_rays; k++) {
+        glm::vec3 inv = 1.0f / dirs[k];
+        float best = world, t;
+        int hit = -1;
+        for (int i = 0; i < count; i++)
+            if (ray_aabb(origins[k], inv, boxes[i], best, &t) && t <= best) {
+                best = t;
+                hit = i;
+            }
+        // при равных t попасть могли в разные коробки
+        if (hit != tree_hit[k] && !(hit >= 0 && tree_hit[k] >= 0 && fabs(best - tree_t[k]) < 1e-5f)) ok = false;
+    }
+    double ray_brute_us = elapsed_us(start) / brute_rays;
+
+    // пирамида видимости: камера на краю мира смотрит в центр
+    glm::mat4 proj = glm::perspective(glm::radians(60.0f), 4.0f / 3.0f, 0.1f, world * 0.5f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, world * 0.5f, 0.0f), glm::vec3(world * 0.5f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 vp = proj * view;
+    const int frames = 100, brute_frames = 10;
+    vector<int> visible;
+    start = Clock::now();
+    for (int f = 0; f < frames; f++) tree.query_frustum(vp, visible);
+    double frustum_us = elapsed_us(start) / frames;
+    size_t brute_visible = 0;
+    start = Clock::now();
+    for (int f = 0; f < brute_frames; f++) {
+        brute_visible = 0;
+        // дерево отсекает по расширенным коробкам, перебор - по ним же
+        for (int i = 0; i < count; i++)
+            if (in_frustum(vp, tree.fat_box(proxies[i]))) brute_visible++;
+    }
+    double frustum_brute_us = elapsed_us(start) / brute_frames;
+    if (brute_visible != visible.size()) ok = false;
+
+    printf("bvh  %6d objects, height %2d: build %7.2f ms | ray %7.2f us (brute %8.1f us) | frustum %8.1f us, %zu visible (brute %8.1f us)%s\n",
+        count, tree.height(), build_us / 1000.0, ray_us, ray_brute_us, frustum_us, visible.size(), frustum_brute_us,
+        ok ? "" : " | MISMATCH");
+    return ok;
+}
+
+static void bench_rope() {
+    const int ropes = 300, segments = 48;
+    RopeSystem system;
+    system.floor_y = -2.0f;
+    for (int r = 0; r < ropes; r++) {
+        // провисающий шнур: квадратичная кривая Безье
+        vector<glm::vec3> points;
+        glm::vec3 p0(2.96f, -0.2f, r * 0.01f), p1(1.8f, -1.0f, r * 0.01f), p2(0.38f, -1.1f, r * 0.01f);
+        for (int i = 0; i <= segments; i++) {
+            float t = (float)i / segments;
+            points.push_back((1 - t) * (1 - t) * p0 + 2 * (1 - t) * t * p1 + t * t * p2);
+        }
+        system.add(points);
+    }
+    const int steps = 1000;
+    auto start = Clock::now();
+    for (int s = 0; s < steps; s++) system.simulate(0.001f, 1);
+    double step_ms = elapsed_us(start) / 1000.0 / steps;
+    printf("rope %d ropes x %d particles: %.3f ms per 1 ms step (%.0f%% of a core at 1 kHz)\n",
+        ropes, segments + 1, step_ms, step_ms * 100.0);
+}
+
+static void bench_tube() {
+    const int samples = 256, radial = 16;
+    vector<glm::vec3> points(samples);
+    for (int i = 0; i < samples; i++) {
+        float t = i / (float)(samples - 1);
+        points[i] = glm::vec3(cos(t * 12.0f) * 0.5f, t * 3.0f, sin(t * 12.0f) * 0.5f);
+    }
+    vector<glm::vec3> out((size_t)samples * radial);
+    TubeSweep sweep;
+    const int iterations = 20000;
+    auto start = Clock::now();
+    for (int k = 0; k < iterations; k++) sweep.build(points.data(), samples, 0.01f, radial, out.data());
+    double us = elapsed_us(start) / iterations;
+    printf("tube %d samples x %d radial: %.2f us per sweep (%.1f ns per vertex)\n",
+        samples, radial, us, us * 1000.0 / (samples * radial));
+}
+
+static void bench_pick() {
+    // сфера 200 x 125 четырёхугольников - 50k треугольников
+    const int rings = 200, sectors = 125;
+    SimpleMesh mesh;
+    for (int i = 0; i <= rings; i++)
+        for (int j = 0; j <= sectors; j++) {
+            float theta = 3.14159265f * i / rings, phi = 6.2831853f * j / sectors;
+            mesh.verts.push_back(glm::vec3(sin(theta) * cos(phi), cos(theta), sin(theta) * sin(phi)));
+        }
+    for (int i = 0; i < rings; i++)
+        for (int j = 0; j < sectors; j++) {
+            GLuint a = i * (sectors + 1) + j, b = a + 1, c = a + sectors + 1, d = c + 1;
+            mesh.inds.insert(mesh.inds.end(), { a, c, b, b, c, d });
+        }
+    PickMesh pick;
+    pick.build(mesh);
+
+    mt19937 rng(1);
+    uniform_real_distribution<float> signed_unit(-1.0f, 1.0f);
+    const int rays = 2000;
+    int hits = 0;
+    auto start = Clock::now();
+    for (int r = 0; r < rays; r++) {
+        glm::vec3 origin(signed_unit(rng) * 0.3f, signed_unit(rng) * 0.3f, 5.0f);
+        glm::vec3 target(signed_unit(rng) * 1.2f, signed_unit(rng) * 1.2f, 0.0f);
+        if (pick.ray_cast(origin, target - origin, 10.0f) >= 0.0f) hits++;
+    }
+    double us = elapsed_us(start) / rays;
+    printf("pick %zu triangles: %.1f us per ray (%d of %d hit)\n", pick.triangle_count(), us, hits, rays);
+}
+
+int main(int argc, char** argv) {
+    const char* what = argc > 1 ? argv[1] : "all";
+    bool all = !strcmp(what, "all");
+    if (!all && strcmp(what, "bvh") && strcmp(what, "rope") && strcmp(what, "tube") && strcmp(what, "pick")) {
+        fprintf(stderr, "usage: bench [all|bvh|rope|tube|pick] [N]\n");
+        return 1;
+    }
+
+    bool ok = true;
+    if (all || !strcmp(what, "bvh")) {
+        int count = argc > 2 ? atoi(argv[2]) : 0;
+        if (count > 0) ok = bench_bvh(count);
+        else
+            for (int n : { 10000, 30000, 100000 }) ok = bench_bvh(n) && ok;
+    }
+    if (all || !strcmp(what, "rope")) bench_rope();
+    if (all || !strcmp(what, "tube")) bench_tube();
+    if (all || !strcmp(what, "pick")) bench_pick();
+    return ok ? 0 : 1;
+}
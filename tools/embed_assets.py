@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+"""Generates a C++ header with asset files embedded as constexpr byte arrays.
+
+Used as a pre-build step of pr.vcxproj (see the EmbedAssets target):
+
+    embed_assets.py -o generated/embedded_assets.h --root <dir> vs.glsl fs.glsl ...
+
+Assets are looked up at runtime by their path relative to --root, with
+forward slashes (see LoadAsset in Assets.cpp).
+"""
+import argparse
+import os
+import sys
+
+
+def c_array(data):
+    lines = []
+    for i in range(0, len(data), 20):
+        lines.append("    " + ",".join("0x%02x" % b for b in data[i:i + 20]) + ",")
+    # zero terminator so text assets can be used as C strings; not counted in size
+    lines.append("    0x00")
+    return "\n".join(lines)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__)
+    ap.add_argument("-o", "--output", required=True)
+    ap.add_argument("--root", default=".")
+    ap.add_argument("files", nargs="+")
+    args = ap.parse_args()
+
+    out = []
+    out.append("// Generated by tools/embed_assets.py - do not edit.")
+    out.append("#pragma once")
+    out.append("")
+    out.append("namespace embedded {")
+    entries = []
+    for i, name in enumerate(args.files):
+        path = os.path.join(args.root, name)
+        if not os.path.isfile(path):
+            print("embed_assets: skipping missing %s" % path, file=sys.stderr)
+            continue
+        with open(path, "rb") as f:
+            data = f.read()
+        out.append("alignas(16) constexpr unsigned char asset_%d[] = {" % i)
+        out.append(c_array(data))
+        out.append("};")
+        entries.append('    { "%s", asset_%d, %d },' % (name.replace("\\", "/"), i, len(data)))
+    out.append("")
+    out.append("constexpr EmbeddedAsset table[] = {")
+    out.extend(entries)
+    out.append('    { nullptr, nullptr, 0 }')
+    out.append("};")
+    out.append("}")
+    out.append("")
+
+    os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+    text = "\n".join(out)
+    # keep the timestamp when nothing changed so the project is not rebuilt
+    if os.path.isfile(args.output):
+        with open(args.output) as f:
+            if f.read() == text:
+                return 0
+    with open(args.output, "w") as f:
+        f.write(text)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())